@@ -0,0 +1,67 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "analysis.h"
+
+int loopdepth[MAX_INSTRUCTIONS];
+int loopcount[MAX_FUNCTIONS];
+
+
+// is this a conditional branch instruction (OP_EQ-OP_GEF)
+int is_branch(vmop_t op) {
+	return op >= OP_EQ && op <= OP_GEF;
+}
+
+
+// instruction index a jump/branch goes to, or -1 if not a branch or not statically known
+int branch_target(int index) {
+	instruction_t* instr = &instructions[index];
+	int target = -1;
+
+	if (is_branch(instr->opcode))
+		target = instr->param;
+	else if (instr->opcode == OP_JUMP && index > 0 && instructions[index - 1].opcode == OP_CONST)
+		target = instructions[index - 1].param;
+
+	if (target < 0 || target >= instructioncount)
+		return -1;
+
+	return target;
+}
+
+
+// find loops via back-edges and fill loopdepth/loopcount
+// a branch backwards to a target within the same function closes a loop that covers
+// every instruction from the target to the branch. lcc emits structured code, so
+// nesting depth is just the number of these ranges that cover an instruction
+void find_loops(void) {
+	memset(loopdepth, 0, sizeof(int) * instructioncount);
+
+	for (int f = 0; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		loopcount[f] = 0;
+
+		// mark loop starts/ends as +1/-1, then sum across the function
+		for (int index = func->start; index < func->end; index++) {
+			int target = branch_target(index);
+			if (target < func->start || target > index)
+				continue;
+			loopdepth[target]++;
+			if (index + 1 < func->end)
+				loopdepth[index + 1]--;
+			loopcount[f]++;
+		}
+		for (int index = func->start + 1; index < func->end; index++)
+			loopdepth[index] += loopdepth[index - 1];
+	}
+}
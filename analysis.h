@@ -0,0 +1,32 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_ANALYSIS_H
+#define QVMOPS_ANALYSIS_H
+
+#include "qvm.h"
+
+// loop nesting depth of each instruction (filled by find_loops)
+extern int loopdepth[MAX_INSTRUCTIONS];
+// number of loops (back-edges) found in each function
+extern int loopcount[MAX_FUNCTIONS];
+
+// is this a conditional branch instruction (OP_EQ-OP_GEF)
+int is_branch(vmop_t op);
+
+// instruction index a jump/branch goes to, or -1 if not a branch or not statically known
+int branch_target(int index);
+
+// find loops via back-edges and fill loopdepth/loopcount
+void find_loops(void);
+
+#endif // QVMOPS_ANALYSIS_H
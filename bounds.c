@@ -0,0 +1,364 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "analysis.h"
+#include "stack.h"
+#include "jumptable.h"
+#include "bounds.h"
+
+uint8_t bounds[MAX_INSTRUCTIONS];
+
+// kinds of value on the operand stack
+enum {
+	RANGE_UNKNOWN,
+	RANGE_ABS,			// an integer (or data address) between lo and hi
+	RANGE_STACK,		// the function's program stack pointer plus between lo and hi
+};
+
+#define RANGE_STACK_SIZE 64
+typedef struct rangeval_s {
+	int kind;
+	int64_t lo;
+	int64_t hi;
+} rangeval_t;
+typedef struct rangestack_s {
+	rangeval_t values[RANGE_STACK_SIZE];
+	int depth;
+} rangestack_t;
+
+
+static void range_push(rangestack_t* stack, int kind, int64_t lo, int64_t hi) {
+	// results that may have wrapped around could be anything
+	if (kind != RANGE_UNKNOWN && (lo < INT32_MIN || hi > INT32_MAX))
+		kind = RANGE_UNKNOWN;
+	// drop the bottom of the stack rather than overflow
+	if (stack->depth == RANGE_STACK_SIZE) {
+		memmove(stack->values, stack->values + 1, (RANGE_STACK_SIZE - 1) * sizeof(rangeval_t));
+		stack->depth--;
+	}
+	stack->values[stack->depth].kind = kind;
+	stack->values[stack->depth].lo = lo;
+	stack->values[stack->depth].hi = hi;
+	stack->depth++;
+}
+
+
+static rangeval_t range_pop(rangestack_t* stack) {
+	rangeval_t unknown = { RANGE_UNKNOWN, 0, 0 };
+	if (!stack->depth)
+		return unknown;
+	return stack->values[--stack->depth];
+}
+
+
+// is this value a single known integer
+static int range_const(rangeval_t v) {
+	return v.kind == RANGE_ABS && v.lo == v.hi;
+}
+
+
+// check an access of size bytes at an address
+// stack accesses are inside the function's frame or the frames above it (at least VMMAIN_CALL_STACK bytes);
+// the engine checks the program stack itself for overflow on OP_ENTER
+static int check_access(rangeval_t v, int64_t size, int framesize, int64_t total) {
+	if (v.kind == RANGE_ABS) {
+		if (v.lo >= 0 && v.hi + size <= total)
+			return BOUNDS_IN;
+		if (v.hi < 0 || v.lo >= total)
+			return BOUNDS_OUT;
+	}
+	else if (v.kind == RANGE_STACK) {
+		if (v.lo >= 0 && v.hi + size <= framesize + VMMAIN_CALL_STACK)
+			return BOUNDS_IN;
+	}
+	return BOUNDS_UNKNOWN;
+}
+
+
+// range of a product of two ranges
+static void range_mul(rangestack_t* stack, rangeval_t a, rangeval_t b, int isunsigned) {
+	int64_t p[4];
+	int64_t lo, hi;
+
+	if (a.kind != RANGE_ABS || b.kind != RANGE_ABS || (isunsigned && (a.lo < 0 || b.lo < 0))) {
+		range_push(stack, RANGE_UNKNOWN, 0, 0);
+		return;
+	}
+	p[0] = a.lo * b.lo;
+	p[1] = a.lo * b.hi;
+	p[2] = a.hi * b.lo;
+	p[3] = a.hi * b.hi;
+	lo = hi = p[0];
+	for (int i = 1; i < 4; i++) {
+		if (p[i] < lo)
+			lo = p[i];
+		if (p[i] > hi)
+			hi = p[i];
+	}
+	range_push(stack, RANGE_ABS, lo, hi);
+}
+
+
+// fill bounds array by tracking value ranges on the operand stack
+void find_bounds(void) {
+	int64_t total = (int64_t)datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT] + datasize[SEGMENT_BSS];
+	rangestack_t stack;
+	uint8_t* entry;
+	int framesize = 0;
+
+	memset(bounds, BOUNDS_NONE, instructioncount);
+
+	// values reaching a jump target may come from elsewhere
+	entry = (uint8_t*)calloc(instructioncount + 1, 1);
+	if (!entry) {
+		fprintf(stderr, "Unable to allocate bounds memory\n");
+		return;
+	}
+	for (int index = 0; index < instructioncount; index++) {
+		int target = branch_target(index);
+		if (target >= 0 && target < instructioncount)
+			entry[target] = 1;
+	}
+	for (int t = 0; t < jumptablecount; t++) {
+		for (int i = 0; i < jumptables[t].count; i++)
+			entry[jumptable_target(&jumptables[t], i)] = 1;
+	}
+
+	stack.depth = 0;
+	for (int index = 0; index < instructioncount; index++) {
+		instruction_t* instr = &instructions[index];
+		rangeval_t a, b;
+		int pops, pushes;
+		int in, out;
+
+		if (entry[index] || instr->opcode == OP_ENTER)
+			stack.depth = 0;
+
+		switch (instr->opcode) {
+		case OP_ENTER:
+			framesize = instr->param;
+			break;
+		case OP_CONST:
+			range_push(&stack, RANGE_ABS, instr->param, instr->param);
+			break;
+		case OP_LOCAL:
+			range_push(&stack, RANGE_STACK, instr->param, instr->param);
+			break;
+		case OP_ADD:
+			b = range_pop(&stack);
+			a = range_pop(&stack);
+			if (a.kind == RANGE_ABS && b.kind == RANGE_ABS)
+				range_push(&stack, RANGE_ABS, a.lo + b.lo, a.hi + b.hi);
+			else if ((a.kind == RANGE_STACK && b.kind == RANGE_ABS) || (a.kind == RANGE_ABS && b.kind == RANGE_STACK))
+				range_push(&stack, RANGE_STACK, a.lo + b.lo, a.hi + b.hi);
+			else
+				range_push(&stack, RANGE_UNKNOWN, 0, 0);
+			break;
+		case OP_SUB:
+			b = range_pop(&stack);
+			a = range_pop(&stack);
+			if (a.kind != RANGE_UNKNOWN && b.kind == RANGE_ABS)
+				range_push(&stack, a.kind, a.lo - b.hi, a.hi - b.lo);
+			else
+				range_push(&stack, RANGE_UNKNOWN, 0, 0);
+			break;
+		case OP_MULI:
+		case OP_MULU:
+			b = range_pop(&stack);
+			a = range_pop(&stack);
+			range_mul(&stack, a, b, instr->opcode == OP_MULU);
+			break;
+		case OP_LSH:
+			b = range_pop(&stack);
+			a = range_pop(&stack);
+			if (a.kind == RANGE_ABS && a.lo >= 0 && range_const(b) && b.lo >= 0 && b.lo < 32)
+				range_push(&stack, RANGE_ABS, a.lo << b.lo, a.hi << b.lo);
+			else
+				range_push(&stack, RANGE_UNKNOWN, 0, 0);
+			break;
+		case OP_RSHI:
+		case OP_RSHU:
+			b = range_pop(&stack);
+			a = range_pop(&stack);
+			if (!range_const(b) || b.lo < 0 || b.lo >= 32)
+				range_push(&stack, RANGE_UNKNOWN, 0, 0);
+			else if (a.kind == RANGE_ABS && (a.lo >= 0 || instr->opcode == OP_RSHI))
+				range_push(&stack, RANGE_ABS, a.lo >> b.lo, a.hi >> b.lo);
+			else if (instr->opcode == OP_RSHU && b.lo > 0)
+				range_push(&stack, RANGE_ABS, 0, 0xFFFFFFFFll >> b.lo);
+			else
+				range_push(&stack, RANGE_UNKNOWN, 0, 0);
+			break;
+		case OP_BAND:
+			// masking with a non-negative constant limits the result whatever the other side is
+			b = range_pop(&stack);
+			a = range_pop(&stack);
+			if (range_const(a) && !range_const(b)) {
+				rangeval_t t = a;
+				a = b;
+				b = t;
+			}
+			if (range_const(b) && b.lo >= 0)
+				range_push(&stack, RANGE_ABS, 0, a.kind == RANGE_ABS && a.lo >= 0 && a.hi < b.lo ? a.hi : b.lo);
+			else
+				range_push(&stack, RANGE_UNKNOWN, 0, 0);
+			break;
+		case OP_MODI:
+		case OP_MODU:
+			b = range_pop(&stack);
+			a = range_pop(&stack);
+			if (!range_const(b) || b.lo <= 0)
+				range_push(&stack, RANGE_UNKNOWN, 0, 0);
+			else if (instr->opcode == OP_MODU || (a.kind == RANGE_ABS && a.lo >= 0))
+				range_push(&stack, RANGE_ABS, 0, b.lo - 1);
+			else
+				range_push(&stack, RANGE_ABS, -(b.lo - 1), b.lo - 1);
+			break;
+		case OP_SEX8:
+			range_pop(&stack);
+			range_push(&stack, RANGE_ABS, -128, 127);
+			break;
+		case OP_SEX16:
+			range_pop(&stack);
+			range_push(&stack, RANGE_ABS, -32768, 32767);
+			break;
+		case OP_LOAD1:
+		case OP_LOAD2:
+		case OP_LOAD4:
+			a = range_pop(&stack);
+			bounds[index] = (uint8_t)check_access(a, instr->opcode == OP_LOAD1 ? 1 : instr->opcode == OP_LOAD2 ? 2 : 4, framesize, total);
+			if (instr->opcode == OP_LOAD1)
+				range_push(&stack, RANGE_ABS, 0, 0xFF);
+			else if (instr->opcode == OP_LOAD2)
+				range_push(&stack, RANGE_ABS, 0, 0xFFFF);
+			else
+				range_push(&stack, RANGE_UNKNOWN, 0, 0);
+			break;
+		case OP_STORE1:
+		case OP_STORE2:
+		case OP_STORE4:
+			range_pop(&stack);
+			a = range_pop(&stack);
+			bounds[index] = (uint8_t)check_access(a, instr->opcode == OP_STORE1 ? 1 : instr->opcode == OP_STORE2 ? 2 : 4, framesize, total);
+			break;
+		case OP_BLOCK_COPY:
+			b = range_pop(&stack);
+			a = range_pop(&stack);
+			in = check_access(a, instr->param, framesize, total);
+			out = check_access(b, instr->param, framesize, total);
+			if (in == BOUNDS_OUT || out == BOUNDS_OUT)
+				bounds[index] = BOUNDS_OUT;
+			else if (in == BOUNDS_IN && out == BOUNDS_IN)
+				bounds[index] = BOUNDS_IN;
+			else
+				bounds[index] = BOUNDS_UNKNOWN;
+			break;
+		default:
+			opcodestack(instr->opcode, &pops, &pushes);
+			while (pops--)
+				range_pop(&stack);
+			while (pushes--)
+				range_push(&stack, RANGE_UNKNOWN, 0, 0);
+		}
+
+		if (instr->opcode == OP_JUMP || instr->opcode == OP_LEAVE)
+			stack.depth = 0;
+	}
+
+	free(entry);
+}
+
+
+// output counts of provable accesses and the list of out-of-bounds ones
+void report_bounds(output_t* h) {
+	static const char* kinds[3] = { "loads", "stores", "block copies" };
+	int counts[3][4] = { { 0, }, };
+	int outcount = 0;
+
+	puts("Processing bounds check report...");
+
+	find_bounds();
+
+	for (int index = 0; index < instructioncount; index++) {
+		vmop_t op = instructions[index].opcode;
+		int kind;
+		if (bounds[index] == BOUNDS_NONE)
+			continue;
+		if (op == OP_LOAD1 || op == OP_LOAD2 || op == OP_LOAD4)
+			kind = 0;
+		else if (op == OP_BLOCK_COPY)
+			kind = 2;
+		else
+			kind = 1;
+		counts[kind][bounds[index]]++;
+		if (bounds[index] == BOUNDS_OUT)
+			outcount++;
+	}
+
+	out_puts(h, "\n\nBOUNDS CHECKS\n=============\n");
+	out_printf(h, "Accesses checked against the data image (0x%X bytes), and the function's frame for local variables\n",
+		datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT] + datasize[SEGMENT_BSS]);
+	out_printf(h, "%-12s %8s %8s %8s %8s\n", "", "TOTAL", "IN", "OUT", "UNKNOWN");
+	for (int kind = 0; kind < 3; kind++) {
+		int total = counts[kind][BOUNDS_IN] + counts[kind][BOUNDS_OUT] + counts[kind][BOUNDS_UNKNOWN];
+		out_printf(h, "%-12s %8d %8d %8d %8d\n", kinds[kind], total, counts[kind][BOUNDS_IN], counts[kind][BOUNDS_OUT], counts[kind][BOUNDS_UNKNOWN]);
+	}
+
+	if (!outcount)
+		return;
+	out_puts(h, "\nAccesses that are always out of bounds:\n");
+	for (int index = 0; index < instructioncount; index++) {
+		function_t* func;
+		if (bounds[index] != BOUNDS_OUT)
+			continue;
+		func = find_function(index);
+		out_printf(h, "%06d %-9s %s+%d\n", index, opcodename(instructions[index].opcode),
+			func ? function_name(func->start) : "?", func ? index - func->start : index);
+	}
+}
+
+
+// write the bounds array as a .bounds file
+int write_bounds(const char* file) {
+	FILE* h;
+	boundsheader_t bheader;
+	int ok;
+
+	printf("Writing %s...\n", file);
+
+	h = fopen(file, "wb");
+	if (!h) {
+		fprintf(stderr, "Unable to open %s for writing\n", file);
+		return 0;
+	}
+
+	bheader.magic = BOUNDS_MAGIC;
+	bheader.version = BOUNDS_VERSION;
+	bheader.codecrc = codecrc;
+	bheader.instructioncount = instructioncount;
+	bheader.datasize = datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT] + datasize[SEGMENT_BSS];
+	bheader.reserved = 0;
+	fwrite(&bheader, sizeof(bheader), 1, h);
+	fwrite(bounds, 1, instructioncount, h);
+	ok = !ferror(h);
+	fclose(h);
+
+	if (!ok)
+		fprintf(stderr, "Error writing %s\n", file);
+	return ok;
+}
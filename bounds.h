@@ -0,0 +1,55 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_BOUNDS_H
+#define QVMOPS_BOUNDS_H
+
+#include <stdint.h>
+#include "qvm.h"
+#include "output.h"
+
+// magic number at start of .bounds files ("QBND")
+#define BOUNDS_MAGIC	0x444E4251
+#define BOUNDS_VERSION	1
+
+// result of checking each instruction's memory access
+enum {
+	BOUNDS_NONE,			// not a load, store or block copy
+	BOUNDS_UNKNOWN,			// address can't be proven either way, must be masked
+	BOUNDS_IN,				// always inside the data image, mask can be skipped
+	BOUNDS_OUT,				// never inside the data image
+};
+
+// .bounds file layout (little endian):
+//   boundsheader_t
+//   one BOUNDS_* byte per instruction
+typedef struct boundsheader_s {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t codecrc;			// CRC-32 of the code segment, as stored in the .qvm
+	int32_t instructioncount;
+	int32_t datasize;			// size of the data image (DATA + LIT + BSS) accesses were checked against
+	int32_t reserved;
+} boundsheader_t;
+
+extern uint8_t bounds[MAX_INSTRUCTIONS];
+
+// fill bounds array by tracking value ranges on the operand stack
+void find_bounds(void);
+
+// output counts of provable accesses and the list of out-of-bounds ones
+void report_bounds(output_t* h);
+
+// write the bounds array as a .bounds file
+int write_bounds(const char* file);
+
+#endif // QVMOPS_BOUNDS_H
@@ -0,0 +1,132 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "analysis.h"
+#include "cost.h"
+
+// cost summary of a single function
+typedef struct funccost_s {
+	int func;			// index into functions[]
+	int instrs;
+	int loops;
+	int maxdepth;
+	int calls;
+	int traps;
+	int64_t cost;
+} funccost_t;
+
+
+// static cost estimate of a single instruction (not counting loop depth)
+int instruction_cost(int index) {
+	instruction_t* instr = &instructions[index];
+
+	switch (instr->opcode) {
+	case OP_CALL:
+		return 5;
+	case OP_DIVI:
+	case OP_DIVU:
+	case OP_MODI:
+	case OP_MODU:
+	case OP_DIVF:
+		return 8;
+	case OP_CVIF:
+	case OP_CVFI:
+		return 3;
+	case OP_NEGF:
+	case OP_ADDF:
+	case OP_SUBF:
+	case OP_MULF:
+	case OP_EQF:
+	case OP_NEF:
+	case OP_LTF:
+	case OP_LEF:
+	case OP_GTF:
+	case OP_GEF:
+		return 2;
+	case OP_BLOCK_COPY:
+		// param is the number of bytes copied
+		return 4 + (instr->param > 0 ? instr->param / 4 : 0);
+	default:
+		return 1;
+	}
+}
+
+
+// sort by cost, highest first
+static int compare_cost(const void* a, const void* b) {
+	const funccost_t* fa = (const funccost_t*)a;
+	const funccost_t* fb = (const funccost_t*)b;
+	if (fa->cost != fb->cost)
+		return fa->cost < fb->cost ? 1 : -1;
+	return fa->func - fb->func;
+}
+
+
+// output per-function cost and loop report, sorted by estimated cost
+void report_cost(output_t* h) {
+	funccost_t* costs;
+
+	puts("Processing function cost report...");
+
+	find_loops();
+
+	costs = (funccost_t*)calloc(functioncount ? functioncount : 1, sizeof(funccost_t));
+	if (!costs) {
+		fprintf(stderr, "Unable to allocate cost report memory\n");
+		return;
+	}
+
+	for (int f = 0; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		funccost_t* fc = &costs[f];
+
+		fc->func = f;
+		fc->instrs = func->end - func->start;
+		fc->loops = loopcount[f];
+
+		for (int index = func->start; index < func->end; index++) {
+			int depth = loopdepth[index];
+			int64_t cost = instruction_cost(index);
+
+			if (depth > fc->maxdepth)
+				fc->maxdepth = depth;
+			if (depth > MAX_LOOP_DEPTH)
+				depth = MAX_LOOP_DEPTH;
+			while (depth--)
+				cost *= LOOP_WEIGHT;
+			fc->cost += cost;
+
+			if (instructions[index].opcode == OP_CALL) {
+				if (index > 0 && instructions[index - 1].opcode == OP_CONST && instructions[index - 1].param < 0)
+					fc->traps++;
+				else
+					fc->calls++;
+			}
+		}
+	}
+
+	qsort(costs, functioncount, sizeof(funccost_t), compare_cost);
+
+	out_puts(h, "\n\nFUNCTION COST\n=============\n");
+	out_printf(h, "Cost is weighted by opcode and multiplied by %d for each level of loop nesting\n", LOOP_WEIGHT);
+	out_printf(h, "%12s %8s %6s %5s %6s %6s  %s\n", "COST", "INSTRS", "LOOPS", "DEPTH", "CALLS", "TRAPS", "FUNCTION");
+	for (int f = 0; f < functioncount; f++) {
+		funccost_t* fc = &costs[f];
+		out_printf(h, "%12lld %8d %6d %5d %6d %6d  %s\n", (long long)fc->cost, fc->instrs, fc->loops, fc->maxdepth, fc->calls, fc->traps, function_name(functions[fc->func].start));
+	}
+
+	free(costs);
+}
@@ -0,0 +1,29 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_COST_H
+#define QVMOPS_COST_H
+
+#include "output.h"
+
+// each level of loop nesting multiplies an instruction's cost by this much
+#define LOOP_WEIGHT		10
+// deeper nesting than this is treated as this deep
+#define MAX_LOOP_DEPTH	6
+
+// static cost estimate of a single instruction (not counting loop depth)
+int instruction_cost(int index);
+
+// output per-function cost and loop report, sorted by estimated cost
+void report_cost(output_t* h);
+
+#endif // QVMOPS_COST_H
@@ -0,0 +1,652 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#include "deflate.h"
+#include "util.h"
+
+// LZ77 parameters
+#define WINDOW_SIZE		32768
+#define MIN_MATCH		3
+#define MAX_MATCH		258
+#define HASH_BITS		15
+#define HASH_SIZE		(1 << HASH_BITS)
+#define MAX_CHAIN		64			// max hash chain entries checked per position
+#define GOOD_MATCH		32			// stop searching once a match this long is found
+
+// huffman alphabet sizes
+#define LITLEN_CODES	286
+#define DIST_CODES		30
+#define CODELEN_CODES	19
+#define MAX_BITS		15
+#define MAX_CODELEN_BITS 7
+
+// a single LZ77 token: literal (len == 0, dist is the byte) or match
+typedef struct token_s {
+	uint16_t len;
+	uint16_t dist;
+} token_t;
+
+// huffman code for a single alphabet
+typedef struct hufftree_s {
+	uint8_t lengths[LITLEN_CODES];
+	uint16_t codes[LITLEN_CODES];		// bit-reversed for LSB-first output
+} hufftree_t;
+
+struct deflate_s {
+	FILE* h;
+	int error;
+
+	// bit output
+	uint64_t bitbuf;
+	int bitcount;
+	uint8_t outbuf[65536];
+	int outpos;
+
+	// gzip trailer
+	uint32_t crc;
+	uint32_t size;
+
+	// LZ77 state. window holds WINDOW_SIZE bytes of history followed by the chunk being compressed
+	uint8_t window[WINDOW_SIZE + DEFLATE_CHUNK];
+	int history;						// bytes of history currently in window
+	int head[HASH_SIZE];
+	int prev[WINDOW_SIZE + DEFLATE_CHUNK];
+	token_t tokens[DEFLATE_CHUNK];
+	int tokencount;
+
+	// input waiting to be compressed
+	uint8_t* pending;
+	int pendinglen;
+
+	// compression thread
+	int threaded;
+	uint8_t* work;						// chunk handed to the thread
+	int worklen;
+	int busy;							// thread is compressing work
+	int quit;
+#ifdef _WIN32
+	HANDLE thread;
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE cond;
+#else
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+#endif
+};
+
+static const short length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const short length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const short dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const short dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const uint8_t codelen_order[CODELEN_CODES] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+
+// write buffered compressed bytes to the file
+static void flush_out(deflate_t* z) {
+	if (z->outpos && fwrite(z->outbuf, 1, z->outpos, z->h) != (size_t)z->outpos)
+		z->error = 1;
+	z->outpos = 0;
+}
+
+
+// write count bits (LSB first)
+static void put_bits(deflate_t* z, uint32_t bits, int count) {
+	z->bitbuf |= (uint64_t)bits << z->bitcount;
+	z->bitcount += count;
+	while (z->bitcount >= 8) {
+		z->outbuf[z->outpos++] = (uint8_t)z->bitbuf;
+		z->bitbuf >>= 8;
+		z->bitcount -= 8;
+		if (z->outpos == sizeof(z->outbuf))
+			flush_out(z);
+	}
+}
+
+
+// write remaining bits padded to a byte boundary
+static void align_bits(deflate_t* z) {
+	if (z->bitcount)
+		put_bits(z, 0, 8 - z->bitcount);
+}
+
+
+static void put_byte(deflate_t* z, uint8_t b) {
+	put_bits(z, b, 8);
+}
+
+
+// code index for a match length/distance
+static int length_code(int len) {
+	int code = 0;
+	while (code < 28 && length_base[code + 1] <= len)
+		code++;
+	return code;
+}
+static int dist_code(int dist) {
+	int lo = 0;
+	int hi = DIST_CODES - 1;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		if (dist_base[mid] <= dist)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return lo;
+}
+
+
+// compute huffman code lengths for n symbols, limited to limit bits
+static void build_lengths(const uint32_t* freq, int n, int limit, uint8_t* lengths) {
+	uint32_t weight[2 * LITLEN_CODES];
+	int parent[2 * LITLEN_CODES];
+	int alive[2 * LITLEN_CODES];
+	uint32_t scaled[LITLEN_CODES];
+	int used = 0;
+	int last = 0;
+
+	memset(lengths, 0, n);
+	for (int i = 0; i < n; i++) {
+		scaled[i] = freq[i];
+		if (freq[i]) {
+			used++;
+			last = i;
+		}
+	}
+
+	// a tree needs at least two leaves, a single code gets 1 bit
+	if (used == 0)
+		return;
+	if (used == 1) {
+		lengths[last] = 1;
+		return;
+	}
+
+	for (;;) {
+		int nodes = n;
+		int maxlen = 0;
+
+		for (int i = 0; i < n; i++) {
+			weight[i] = scaled[i];
+			alive[i] = scaled[i] != 0;
+			parent[i] = -1;
+		}
+
+		// repeatedly merge the two lightest nodes
+		for (int merges = 0; merges < used - 1; merges++) {
+			int a = -1, b = -1;
+			for (int i = 0; i < nodes; i++) {
+				if (!alive[i])
+					continue;
+				if (a < 0 || weight[i] < weight[a]) {
+					b = a;
+					a = i;
+				}
+				else if (b < 0 || weight[i] < weight[b])
+					b = i;
+			}
+			weight[nodes] = weight[a] + weight[b];
+			alive[nodes] = 1;
+			parent[nodes] = -1;
+			alive[a] = alive[b] = 0;
+			parent[a] = parent[b] = nodes;
+			nodes++;
+		}
+
+		// leaf depth is the number of parents above it
+		for (int i = 0; i < n; i++) {
+			int depth = 0;
+			if (!scaled[i])
+				continue;
+			for (int p = parent[i]; p >= 0; p = parent[p])
+				depth++;
+			lengths[i] = (uint8_t)depth;
+			if (depth > maxlen)
+				maxlen = depth;
+		}
+
+		if (maxlen <= limit)
+			return;
+
+		// flatten the distribution and try again
+		for (int i = 0; i < n; i++) {
+			if (scaled[i])
+				scaled[i] = (scaled[i] >> 1) | 1;
+		}
+	}
+}
+
+
+// assign canonical codes from lengths
+static void build_codes(hufftree_t* tree, int n) {
+	int count[MAX_BITS + 1] = { 0, };
+	int next[MAX_BITS + 1];
+	int code = 0;
+
+	for (int i = 0; i < n; i++)
+		count[tree->lengths[i]]++;
+	count[0] = 0;
+	for (int bits = 1; bits <= MAX_BITS; bits++) {
+		code = (code + count[bits - 1]) << 1;
+		next[bits] = code;
+	}
+
+	for (int i = 0; i < n; i++) {
+		int len = tree->lengths[i];
+		uint16_t rev = 0;
+		if (!len)
+			continue;
+		code = next[len]++;
+		// deflate sends huffman codes MSB first, so reverse them for put_bits
+		for (int b = 0; b < len; b++)
+			rev |= ((code >> b) & 1) << (len - 1 - b);
+		tree->codes[i] = rev;
+	}
+}
+
+
+// run length encode code lengths into the code length alphabet
+// each entry is symbol | (extra bits value << 8)
+static int encode_lengths(const uint8_t* lengths, int n, uint16_t* out, uint32_t* freq) {
+	int count = 0;
+
+	for (int i = 0; i < n;) {
+		int len = lengths[i];
+		int run = 1;
+		while (i + run < n && lengths[i + run] == len)
+			run++;
+
+		if (len == 0 && run >= 3) {
+			int r = run > 138 ? 138 : run;
+			if (r >= 11)
+				out[count++] = 18 | ((r - 11) << 8);
+			else
+				out[count++] = 17 | ((r - 3) << 8);
+			freq[out[count - 1] & 0xFF]++;
+			i += r;
+		}
+		else if (len != 0 && run >= 4) {
+			// first one literally, then repeat it
+			int r = run - 1 > 6 ? 6 : run - 1;
+			out[count++] = (uint16_t)len;
+			freq[len]++;
+			out[count++] = 16 | ((r - 3) << 8);
+			freq[16]++;
+			i += r + 1;
+		}
+		else {
+			out[count++] = (uint16_t)len;
+			freq[len]++;
+			i++;
+		}
+	}
+
+	return count;
+}
+
+
+// find matches in the current chunk and fill tokens
+static void find_matches(deflate_t* z, int start, int end) {
+	z->tokencount = 0;
+
+	for (int pos = start; pos < end;) {
+		int bestlen = 0;
+		int bestdist = 0;
+
+		if (pos + MIN_MATCH <= end) {
+			uint32_t hash = ((z->window[pos] << 10) ^ (z->window[pos + 1] << 5) ^ z->window[pos + 2]) & (HASH_SIZE - 1);
+			int maxlen = end - pos < MAX_MATCH ? end - pos : MAX_MATCH;
+			int chain = MAX_CHAIN;
+
+			for (int cand = z->head[hash]; cand >= 0 && pos - cand <= WINDOW_SIZE && chain--; cand = z->prev[cand]) {
+				int len = 0;
+				if (z->window[cand + bestlen] != z->window[pos + bestlen])
+					continue;
+				while (len < maxlen && z->window[cand + len] == z->window[pos + len])
+					len++;
+				if (len > bestlen) {
+					bestlen = len;
+					bestdist = pos - cand;
+					if (len >= GOOD_MATCH || len == maxlen)
+						break;
+				}
+			}
+
+			z->prev[pos] = z->head[hash];
+			z->head[hash] = pos;
+		}
+
+		if (bestlen >= MIN_MATCH) {
+			z->tokens[z->tokencount].len = (uint16_t)bestlen;
+			z->tokens[z->tokencount].dist = (uint16_t)bestdist;
+			z->tokencount++;
+			// add the rest of the match to the hash chains
+			for (int i = 1; i < bestlen; i++) {
+				int p = pos + i;
+				if (p + MIN_MATCH <= end) {
+					uint32_t hash = ((z->window[p] << 10) ^ (z->window[p + 1] << 5) ^ z->window[p + 2]) & (HASH_SIZE - 1);
+					z->prev[p] = z->head[hash];
+					z->head[hash] = p;
+				}
+			}
+			pos += bestlen;
+		}
+		else {
+			z->tokens[z->tokencount].len = 0;
+			z->tokens[z->tokencount].dist = z->window[pos];
+			z->tokencount++;
+			pos++;
+		}
+	}
+}
+
+
+// write a dynamic huffman block for the current tokens
+static void write_block(deflate_t* z, int final) {
+	hufftree_t litlen, dist, codelen;
+	uint32_t litfreq[LITLEN_CODES] = { 0, };
+	uint32_t distfreq[DIST_CODES] = { 0, };
+	uint32_t clfreq[CODELEN_CODES] = { 0, };
+	uint8_t alllengths[LITLEN_CODES + DIST_CODES];
+	uint16_t rle[LITLEN_CODES + DIST_CODES];
+	int nlit, ndist, nclen, nrle;
+	int matches = 0;
+
+	for (int i = 0; i < z->tokencount; i++) {
+		token_t* t = &z->tokens[i];
+		if (!t->len)
+			litfreq[t->dist]++;
+		else {
+			litfreq[257 + length_code(t->len)]++;
+			distfreq[dist_code(t->dist)]++;
+			matches++;
+		}
+	}
+	litfreq[256] = 1;
+
+	memset(&litlen, 0, sizeof(litlen));
+	memset(&dist, 0, sizeof(dist));
+	memset(&codelen, 0, sizeof(codelen));
+	build_lengths(litfreq, LITLEN_CODES, MAX_BITS, litlen.lengths);
+	build_lengths(distfreq, DIST_CODES, MAX_BITS, dist.lengths);
+	// at least one distance code must be sent even if there are no matches
+	if (!matches)
+		dist.lengths[0] = 1;
+	build_codes(&litlen, LITLEN_CODES);
+	build_codes(&dist, DIST_CODES);
+
+	for (nlit = LITLEN_CODES; nlit > 257 && !litlen.lengths[nlit - 1]; nlit--)
+		;
+	for (ndist = DIST_CODES; ndist > 1 && !dist.lengths[ndist - 1]; ndist--)
+		;
+	memcpy(alllengths, litlen.lengths, nlit);
+	memcpy(alllengths + nlit, dist.lengths, ndist);
+	nrle = encode_lengths(alllengths, nlit + ndist, rle, clfreq);
+
+	build_lengths(clfreq, CODELEN_CODES, MAX_CODELEN_BITS, codelen.lengths);
+	build_codes(&codelen, CODELEN_CODES);
+	for (nclen = CODELEN_CODES; nclen > 4 && !codelen.lengths[codelen_order[nclen - 1]]; nclen--)
+		;
+
+	// block header
+	put_bits(z, final, 1);
+	put_bits(z, 2, 2);
+	put_bits(z, nlit - 257, 5);
+	put_bits(z, ndist - 1, 5);
+	put_bits(z, nclen - 4, 4);
+	for (int i = 0; i < nclen; i++)
+		put_bits(z, codelen.lengths[codelen_order[i]], 3);
+	for (int i = 0; i < nrle; i++) {
+		int sym = rle[i] & 0xFF;
+		put_bits(z, codelen.codes[sym], codelen.lengths[sym]);
+		if (sym == 16)
+			put_bits(z, rle[i] >> 8, 2);
+		else if (sym == 17)
+			put_bits(z, rle[i] >> 8, 3);
+		else if (sym == 18)
+			put_bits(z, rle[i] >> 8, 7);
+	}
+
+	// block data
+	for (int i = 0; i < z->tokencount; i++) {
+		token_t* t = &z->tokens[i];
+		if (!t->len)
+			put_bits(z, litlen.codes[t->dist], litlen.lengths[t->dist]);
+		else {
+			int lc = length_code(t->len);
+			int dc = dist_code(t->dist);
+			put_bits(z, litlen.codes[257 + lc], litlen.lengths[257 + lc]);
+			put_bits(z, t->len - length_base[lc], length_extra[lc]);
+			put_bits(z, dist.codes[dc], dist.lengths[dc]);
+			put_bits(z, t->dist - dist_base[dc], dist_extra[dc]);
+		}
+	}
+	put_bits(z, litlen.codes[256], litlen.lengths[256]);
+}
+
+
+// compress a chunk of input as one block
+static void compress_chunk(deflate_t* z, const uint8_t* buf, int len, int final) {
+	int start;
+
+	z->crc = crc32_buf(z->crc, buf, len);
+	z->size += len;
+
+	// slide the window so only WINDOW_SIZE bytes of history remain before the new chunk
+	if (z->history > WINDOW_SIZE) {
+		int shift = z->history - WINDOW_SIZE;
+		memmove(z->window, z->window + shift, WINDOW_SIZE);
+		for (int i = 0; i < HASH_SIZE; i++)
+			z->head[i] = z->head[i] >= shift ? z->head[i] - shift : -1;
+		for (int i = 0; i < WINDOW_SIZE; i++)
+			z->prev[i] = z->prev[i + shift] >= shift ? z->prev[i + shift] - shift : -1;
+		z->history = WINDOW_SIZE;
+	}
+
+	start = z->history;
+	memcpy(z->window + start, buf, len);
+	find_matches(z, start, start + len);
+	z->history += len;
+
+	write_block(z, final);
+}
+
+
+#ifdef _WIN32
+#define LOCK(z)		EnterCriticalSection(&(z)->lock)
+#define UNLOCK(z)	LeaveCriticalSection(&(z)->lock)
+#define WAIT(z)		SleepConditionVariableCS(&(z)->cond, &(z)->lock, INFINITE)
+#define SIGNAL(z)	WakeAllConditionVariable(&(z)->cond)
+#else
+#define LOCK(z)		pthread_mutex_lock(&(z)->lock)
+#define UNLOCK(z)	pthread_mutex_unlock(&(z)->lock)
+#define WAIT(z)		pthread_cond_wait(&(z)->cond, &(z)->lock)
+#define SIGNAL(z)	pthread_cond_broadcast(&(z)->cond)
+#endif
+
+
+// compression thread: compress chunks as they are handed over
+#ifdef _WIN32
+static DWORD WINAPI deflate_thread(LPVOID arg) {
+#else
+static void* deflate_thread(void* arg) {
+#endif
+	deflate_t* z = (deflate_t*)arg;
+
+	LOCK(z);
+	for (;;) {
+		while (!z->busy && !z->quit)
+			WAIT(z);
+		if (!z->busy)
+			break;
+		UNLOCK(z);
+
+		compress_chunk(z, z->work, z->worklen, 0);
+
+		LOCK(z);
+		z->busy = 0;
+		SIGNAL(z);
+	}
+	UNLOCK(z);
+
+	return 0;
+}
+
+
+// wait for the thread to finish its current chunk
+static void wait_idle(deflate_t* z) {
+	LOCK(z);
+	while (z->busy)
+		WAIT(z);
+	UNLOCK(z);
+}
+
+
+// start a gzip stream on an open file, optionally compressing on a separate thread
+deflate_t* deflate_open(FILE* h, int threaded) {
+	// gzip header: magic, deflate, no flags, no mtime, no extra flags, unknown OS
+	static const uint8_t gzheader[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 255 };
+	deflate_t* z;
+
+	z = (deflate_t*)calloc(1, sizeof(deflate_t));
+	if (!z)
+		return NULL;
+	z->h = h;
+	z->pending = (uint8_t*)malloc(DEFLATE_CHUNK);
+	if (!z->pending)
+		goto fail;
+	for (int i = 0; i < HASH_SIZE; i++)
+		z->head[i] = -1;
+
+	for (int i = 0; i < (int)sizeof(gzheader); i++)
+		put_byte(z, gzheader[i]);
+
+	if (threaded) {
+		z->work = (uint8_t*)malloc(DEFLATE_CHUNK);
+		if (!z->work)
+			goto fail;
+#ifdef _WIN32
+		InitializeCriticalSection(&z->lock);
+		InitializeConditionVariable(&z->cond);
+		z->thread = CreateThread(NULL, 0, deflate_thread, z, 0, NULL);
+		if (!z->thread) {
+			DeleteCriticalSection(&z->lock);
+			goto nothread;
+		}
+#else
+		pthread_mutex_init(&z->lock, NULL);
+		pthread_cond_init(&z->cond, NULL);
+		if (pthread_create(&z->thread, NULL, deflate_thread, z)) {
+			pthread_mutex_destroy(&z->lock);
+			pthread_cond_destroy(&z->cond);
+			goto nothread;
+		}
+#endif
+		z->threaded = 1;
+	}
+
+	return z;
+
+nothread:
+	fprintf(stderr, "Unable to start compression thread, compressing on main thread\n");
+	free(z->work);
+	z->work = NULL;
+	return z;
+
+fail:
+	free(z->pending);
+	free(z->work);
+	free(z);
+	return NULL;
+}
+
+
+// add data to the stream
+void deflate_write(deflate_t* z, const uint8_t* buf, size_t len) {
+	while (len) {
+		size_t n = DEFLATE_CHUNK - z->pendinglen;
+		if (n > len)
+			n = len;
+		memcpy(z->pending + z->pendinglen, buf, n);
+		z->pendinglen += (int)n;
+		buf += n;
+		len -= n;
+
+		// always keep the last chunk back so it can be marked as the final block
+		if (z->pendinglen == DEFLATE_CHUNK && len) {
+			if (z->threaded) {
+				uint8_t* swap;
+				wait_idle(z);
+				swap = z->work;
+				z->work = z->pending;
+				z->worklen = z->pendinglen;
+				z->pending = swap;
+				LOCK(z);
+				z->busy = 1;
+				SIGNAL(z);
+				UNLOCK(z);
+			}
+			else
+				compress_chunk(z, z->pending, z->pendinglen, 0);
+			z->pendinglen = 0;
+		}
+	}
+}
+
+
+// finish the stream (does not close the file), returns 0 on write error
+int deflate_close(deflate_t* z) {
+	int ok;
+
+	if (z->threaded) {
+		wait_idle(z);
+		LOCK(z);
+		z->quit = 1;
+		SIGNAL(z);
+		UNLOCK(z);
+#ifdef _WIN32
+		WaitForSingleObject(z->thread, INFINITE);
+		CloseHandle(z->thread);
+		DeleteCriticalSection(&z->lock);
+#else
+		pthread_join(z->thread, NULL);
+		pthread_mutex_destroy(&z->lock);
+		pthread_cond_destroy(&z->cond);
+#endif
+	}
+
+	compress_chunk(z, z->pending, z->pendinglen, 1);
+	align_bits(z);
+
+	// gzip trailer: crc and uncompressed size
+	for (int i = 0; i < 4; i++)
+		put_byte(z, (uint8_t)(z->crc >> (i * 8)));
+	for (int i = 0; i < 4; i++)
+		put_byte(z, (uint8_t)(z->size >> (i * 8)));
+	flush_out(z);
+
+	ok = !z->error;
+	free(z->pending);
+	free(z->work);
+	free(z);
+	return ok;
+}
@@ -0,0 +1,33 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_DEFLATE_H
+#define QVMOPS_DEFLATE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// amount of input compressed into each deflate block
+#define DEFLATE_CHUNK	65536
+
+typedef struct deflate_s deflate_t;
+
+// start a gzip stream on an open file, optionally compressing on a separate thread
+deflate_t* deflate_open(FILE* h, int threaded);
+
+// add data to the stream
+void deflate_write(deflate_t* z, const uint8_t* buf, size_t len);
+
+// finish the stream (does not close the file), returns 0 on write error
+int deflate_close(deflate_t* z);
+
+#endif // QVMOPS_DEFLATE_H
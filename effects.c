@@ -0,0 +1,514 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "analysis.h"
+#include "rewrite.h"
+#include "jumptable.h"
+#include "globals.h"
+#include "effects.h"
+
+int effectflags[MAX_FUNCTIONS];
+
+// a set of globalrefs indexes, kept sorted and unique once finished
+typedef struct globalset_s {
+	int* items;
+	int count;
+	int max;
+} globalset_t;
+
+// what is known about a value on the operand stack
+enum {
+	EFFECTVAL_UNKNOWN,
+	EFFECTVAL_LOCAL,		// an address in the function's stack frame
+	EFFECTVAL_GLOBAL,		// a static data address (possibly plus an unknown offset)
+};
+
+#define EFFECT_STACK_SIZE 64
+typedef struct effectval_s {
+	int kind;
+	int exact;			// EFFECTVAL_GLOBAL is exactly address, not address plus an unknown offset
+	int address;
+} effectval_t;
+typedef struct effectstack_s {
+	effectval_t values[EFFECT_STACK_SIZE];
+	int depth;
+} effectstack_t;
+
+// each function's own flags and globals, then each component's (including everything it calls)
+static int* localflags;
+static globalset_t* localreads;
+static globalset_t* localwrites;
+static int* sccof;
+static int* sccflags;
+static globalset_t* sccreads;
+static globalset_t* sccwrites;
+static int scccount;
+
+// direct calls, by caller
+static int* callstart;
+static int* callto;
+static int callcount;
+
+
+static int set_add(globalset_t* set, int item) {
+	if (set->count == set->max) {
+		int newmax = set->max ? set->max * 2 : 8;
+		int* items = (int*)realloc(set->items, newmax * sizeof(int));
+		if (!items)
+			return 0;
+		set->items = items;
+		set->max = newmax;
+	}
+	set->items[set->count++] = item;
+	return 1;
+}
+
+
+static int compare_int(const void* a, const void* b) {
+	return *(const int*)a - *(const int*)b;
+}
+
+
+// sort and remove duplicates
+static void set_finish(globalset_t* set) {
+	int count = 0;
+
+	if (!set->count)
+		return;
+	qsort(set->items, set->count, sizeof(int), compare_int);
+	for (int i = 0; i < set->count; i++) {
+		if (!count || set->items[count - 1] != set->items[i])
+			set->items[count++] = set->items[i];
+	}
+	set->count = count;
+}
+
+
+static int set_union(globalset_t* set, const globalset_t* other) {
+	for (int i = 0; i < other->count; i++) {
+		if (!set_add(set, other->items[i]))
+			return 0;
+	}
+	return 1;
+}
+
+
+static void set_free(globalset_t* set) {
+	free(set->items);
+	memset(set, 0, sizeof(*set));
+}
+
+
+static void effect_push(effectstack_t* stack, int kind, int exact, int address) {
+	// drop the bottom of the stack rather than overflow
+	if (stack->depth == EFFECT_STACK_SIZE) {
+		memmove(stack->values, stack->values + 1, (EFFECT_STACK_SIZE - 1) * sizeof(effectval_t));
+		stack->depth--;
+	}
+	stack->values[stack->depth].kind = kind;
+	stack->values[stack->depth].exact = exact;
+	stack->values[stack->depth].address = address;
+	stack->depth++;
+}
+
+
+static effectval_t effect_pop(effectstack_t* stack) {
+	effectval_t unknown = { EFFECTVAL_UNKNOWN, 0, 0 };
+	if (!stack->depth)
+		return unknown;
+	return stack->values[--stack->depth];
+}
+
+
+// is this the start of a global big enough to be an array or struct
+// (a pointer plus a constant is usually a field offset, not an index into a global)
+static int is_aggregate(effectval_t v) {
+	globalrefs_t* global;
+	return v.kind == EFFECTVAL_GLOBAL && v.exact && (global = find_global(v.address)) && global->address == v.address && global->size > 4;
+}
+
+
+// note a load or store through an address
+static int effect_access(int f, effectval_t v, int write) {
+	globalrefs_t* global;
+
+	if (v.kind == EFFECTVAL_LOCAL)
+		return 1;
+	if (v.kind == EFFECTVAL_UNKNOWN) {
+		localflags[f] |= write ? EFFECT_WRITES_MEMORY : EFFECT_READS_MEMORY;
+		return 1;
+	}
+
+	// reading LIT is reading a constant
+	if (write)
+		localflags[f] |= EFFECT_WRITES_GLOBAL;
+	else if (v.address < datasize[SEGMENT_DATA] || v.address >= datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT])
+		localflags[f] |= EFFECT_READS_GLOBAL;
+
+	global = find_global(v.address);
+	if (!global)
+		return 1;
+	return set_add(write ? &localwrites[f] : &localreads[f], (int)(global - globalrefs));
+}
+
+
+// find a function's own flags, globals and direct calls
+static int find_local_effects(int f, const uint8_t* entry) {
+	function_t* func = &functions[f];
+	int total = datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT] + datasize[SEGMENT_BSS];
+	effectstack_t stack;
+	int ok = 1;
+
+	stack.depth = 0;
+	for (int index = func->start; index < func->end && ok; index++) {
+		instruction_t* instr = &instructions[index];
+		effectval_t a, b;
+		int pops, pushes;
+
+		if (entry[index])
+			stack.depth = 0;
+
+		switch (instr->opcode) {
+		case OP_CONST:
+			if (!is_code_ref(index) && instr->param >= 0 && instr->param < total)
+				effect_push(&stack, EFFECTVAL_GLOBAL, 1, instr->param);
+			else
+				effect_push(&stack, EFFECTVAL_UNKNOWN, 0, 0);
+			break;
+		case OP_LOCAL:
+			effect_push(&stack, EFFECTVAL_LOCAL, 1, instr->param);
+			break;
+		case OP_ADD:
+		case OP_SUB:
+			// a local or global address plus or minus an index is still in the same place (as far as can be told)
+			b = effect_pop(&stack);
+			a = effect_pop(&stack);
+			if (a.kind == EFFECTVAL_LOCAL || (b.kind == EFFECTVAL_LOCAL && instr->opcode == OP_ADD))
+				effect_push(&stack, EFFECTVAL_LOCAL, 0, 0);
+			else if (a.kind == EFFECTVAL_GLOBAL && b.kind == EFFECTVAL_GLOBAL && a.exact && b.exact)
+				effect_push(&stack, EFFECTVAL_GLOBAL, 1, instr->opcode == OP_ADD ? a.address + b.address : a.address - b.address);
+			else if (is_aggregate(a) || (a.kind == EFFECTVAL_GLOBAL && b.kind == EFFECTVAL_GLOBAL))
+				effect_push(&stack, EFFECTVAL_GLOBAL, 0, a.address);
+			else if (is_aggregate(b) && instr->opcode == OP_ADD)
+				effect_push(&stack, EFFECTVAL_GLOBAL, 0, b.address);
+			else
+				effect_push(&stack, EFFECTVAL_UNKNOWN, 0, 0);
+			break;
+		case OP_LOAD1:
+		case OP_LOAD2:
+		case OP_LOAD4:
+			ok = effect_access(f, effect_pop(&stack), 0);
+			effect_push(&stack, EFFECTVAL_UNKNOWN, 0, 0);
+			break;
+		case OP_STORE1:
+		case OP_STORE2:
+		case OP_STORE4:
+			effect_pop(&stack);
+			ok = effect_access(f, effect_pop(&stack), 1);
+			break;
+		case OP_BLOCK_COPY:
+			b = effect_pop(&stack);
+			a = effect_pop(&stack);
+			ok = effect_access(f, b, 0) && effect_access(f, a, 1);
+			break;
+		case OP_CALL:
+			effect_pop(&stack);
+			if (index > func->start && instructions[index - 1].opcode == OP_CONST) {
+				int target = instructions[index - 1].param;
+				function_t* callee;
+				if (target < 0)
+					localflags[f] |= EFFECT_TRAP;
+				else if ((callee = find_function(target)) && callee->start == target)
+					callto[callcount++] = (int)(callee - functions);
+				else
+					localflags[f] |= EFFECT_INDIRECT;
+			}
+			else
+				localflags[f] |= EFFECT_INDIRECT;
+			effect_push(&stack, EFFECTVAL_UNKNOWN, 0, 0);
+			break;
+		default:
+			opcodestack(instr->opcode, &pops, &pushes);
+			while (pops--)
+				effect_pop(&stack);
+			while (pushes--)
+				effect_push(&stack, EFFECTVAL_UNKNOWN, 0, 0);
+		}
+
+		if (instr->opcode == OP_JUMP || instr->opcode == OP_LEAVE)
+			stack.depth = 0;
+	}
+
+	if (!ok)
+		fprintf(stderr, "Unable to allocate effects memory\n");
+	return ok;
+}
+
+
+// combine a finished strongly connected component's own effects with those of everything it calls
+// components are finished callees first, so those are already complete
+static int finish_component(const int* members, int count) {
+	int scc = scccount++;
+	int ok = 1;
+
+	for (int i = 0; i < count; i++)
+		sccof[members[i]] = scc;
+	if (count > 1)
+		sccflags[scc] |= EFFECT_RECURSIVE;
+
+	for (int i = 0; i < count && ok; i++) {
+		int f = members[i];
+		sccflags[scc] |= localflags[f];
+		ok = set_union(&sccreads[scc], &localreads[f]) && set_union(&sccwrites[scc], &localwrites[f]);
+		for (int c = callstart[f]; c < callstart[f + 1] && ok; c++) {
+			int callee = sccof[callto[c]];
+			if (callee == scc) {
+				sccflags[scc] |= EFFECT_RECURSIVE;
+				continue;
+			}
+			sccflags[scc] |= sccflags[callee];
+			ok = set_union(&sccreads[scc], &sccreads[callee]) && set_union(&sccwrites[scc], &sccwrites[callee]);
+		}
+		set_free(&localreads[f]);
+		set_free(&localwrites[f]);
+	}
+	set_finish(&sccreads[scc]);
+	set_finish(&sccwrites[scc]);
+
+	for (int i = 0; i < count; i++)
+		effectflags[members[i]] = sccflags[scc];
+
+	if (!ok)
+		fprintf(stderr, "Unable to allocate effects memory\n");
+	return ok;
+}
+
+
+// Tarjan's strongly connected components over the direct call graph, without recursion
+static int find_components(void) {
+	int* order = (int*)malloc(functioncount * sizeof(int));
+	int* low = (int*)malloc(functioncount * sizeof(int));
+	int* next = (int*)malloc(functioncount * sizeof(int));
+	int* walk = (int*)malloc(functioncount * sizeof(int));
+	int* pending = (int*)malloc(functioncount * sizeof(int));
+	uint8_t* onstack = (uint8_t*)calloc(functioncount, 1);
+	int counter = 0;
+	int pendingcount = 0;
+	int ok = 1;
+
+	if (!order || !low || !next || !walk || !pending || !onstack) {
+		fprintf(stderr, "Unable to allocate effects memory\n");
+		ok = 0;
+		goto done;
+	}
+	for (int f = 0; f < functioncount; f++)
+		order[f] = -1;
+
+	for (int root = 0; root < functioncount && ok; root++) {
+		int depth = 0;
+		if (order[root] >= 0)
+			continue;
+
+		order[root] = low[root] = counter++;
+		next[root] = callstart[root];
+		pending[pendingcount++] = root;
+		onstack[root] = 1;
+		walk[depth++] = root;
+
+		while (depth && ok) {
+			int v = walk[depth - 1];
+			if (next[v] < callstart[v + 1]) {
+				int w = callto[next[v]++];
+				if (order[w] < 0) {
+					order[w] = low[w] = counter++;
+					next[w] = callstart[w];
+					pending[pendingcount++] = w;
+					onstack[w] = 1;
+					walk[depth++] = w;
+				}
+				else if (onstack[w] && order[w] < low[v])
+					low[v] = order[w];
+				continue;
+			}
+
+			depth--;
+			if (depth && low[v] < low[walk[depth - 1]])
+				low[walk[depth - 1]] = low[v];
+			if (low[v] != order[v])
+				continue;
+
+			// v is the root of a component, everything above it on the pending stack is in it
+			{
+				int first = pendingcount;
+				do {
+					first--;
+					onstack[pending[first]] = 0;
+				} while (pending[first] != v);
+				ok = finish_component(pending + first, pendingcount - first);
+				pendingcount = first;
+			}
+		}
+	}
+
+done:
+	free(order);
+	free(low);
+	free(next);
+	free(walk);
+	free(pending);
+	free(onstack);
+	return ok;
+}
+
+
+static void free_effects(void) {
+	if (localreads) {
+		for (int f = 0; f < functioncount; f++) {
+			set_free(&localreads[f]);
+			set_free(&localwrites[f]);
+		}
+	}
+	if (sccreads) {
+		for (int s = 0; s < functioncount; s++) {
+			set_free(&sccreads[s]);
+			set_free(&sccwrites[s]);
+		}
+	}
+	free(localflags);
+	free(localreads);
+	free(localwrites);
+	free(sccof);
+	free(sccflags);
+	free(sccreads);
+	free(sccwrites);
+	free(callstart);
+	free(callto);
+	localflags = NULL;
+	localreads = localwrites = sccreads = sccwrites = NULL;
+	sccof = sccflags = callstart = callto = NULL;
+	scccount = callcount = 0;
+}
+
+
+// find each function's own loads, stores and calls, then combine them bottom-up over the call graph
+void find_effects(void) {
+	uint8_t* entry;
+	int ok = 1;
+
+	free_effects();
+	memset(effectflags, 0, sizeof(int) * functioncount);
+	if (!functioncount)
+		return;
+
+	find_global_refs();
+
+	localflags = (int*)calloc(functioncount, sizeof(int));
+	localreads = (globalset_t*)calloc(functioncount, sizeof(globalset_t));
+	localwrites = (globalset_t*)calloc(functioncount, sizeof(globalset_t));
+	sccof = (int*)malloc(functioncount * sizeof(int));
+	sccflags = (int*)calloc(functioncount, sizeof(int));
+	sccreads = (globalset_t*)calloc(functioncount, sizeof(globalset_t));
+	sccwrites = (globalset_t*)calloc(functioncount, sizeof(globalset_t));
+	callstart = (int*)malloc((functioncount + 1) * sizeof(int));
+	// there can't be more calls than instructions
+	callto = (int*)malloc((instructioncount + 1) * sizeof(int));
+	entry = (uint8_t*)calloc(instructioncount + 1, 1);
+	if (!localflags || !localreads || !localwrites || !sccof || !sccflags || !sccreads || !sccwrites || !callstart || !callto || !entry) {
+		fprintf(stderr, "Unable to allocate effects memory\n");
+		free(entry);
+		free_effects();
+		return;
+	}
+
+	// values reaching a jump target may come from elsewhere
+	for (int index = 0; index < instructioncount; index++) {
+		int target = branch_target(index);
+		if (target >= 0)
+			entry[target] = 1;
+	}
+	for (int t = 0; t < jumptablecount; t++) {
+		for (int i = 0; i < jumptables[t].count; i++)
+			entry[jumptable_target(&jumptables[t], i)] = 1;
+	}
+
+	for (int f = 0; f < functioncount && ok; f++) {
+		callstart[f] = callcount;
+		ok = find_local_effects(f, entry);
+	}
+	callstart[functioncount] = callcount;
+	free(entry);
+
+	if (!ok || !find_components())
+		free_effects();
+}
+
+
+// output each function's summary, with the globals it reads and writes
+void report_effects(output_t* h) {
+	int pure = 0, readonly = 0, traps = 0;
+
+	puts("Processing function effects report...");
+
+	find_effects();
+	if (!sccof) {
+		free_effects();
+		return;
+	}
+
+	for (int f = 0; f < functioncount; f++) {
+		if (!(effectflags[f] & EFFECT_IMPURE))
+			pure++;
+		else if (!(effectflags[f] & EFFECT_WRITES))
+			readonly++;
+		if (effectflags[f] & EFFECT_TRAP)
+			traps++;
+	}
+
+	out_puts(h, "\n\nFUNCTION EFFECTS\n================\n");
+	out_puts(h, "Side effects of each function and everything it calls (only static global addresses are named)\n");
+	out_printf(h, "Pure: %d, read-only: %d, impure: %d, reaching a system call: %d (of %d functions)\n",
+		pure, readonly, functioncount - pure - readonly, traps, functioncount);
+	out_puts(h, "Flags: T reaches a system call, I calls through a function pointer, R recursive, P reads (or writes) through other pointers\n");
+	out_printf(h, "%-9s %-5s %6s %6s %s\n", "CLASS", "FLAGS", "READS", "WRITES", "FUNCTION");
+
+	for (int f = 0; f < functioncount; f++) {
+		int flags = effectflags[f];
+		globalset_t* reads = &sccreads[sccof[f]];
+		globalset_t* writes = &sccwrites[sccof[f]];
+
+		out_printf(h, "%-9s %c%c%c%c  %6d %6d %s\n",
+			!(flags & EFFECT_IMPURE) ? "pure" : !(flags & EFFECT_WRITES) ? "read-only" : "impure",
+			flags & EFFECT_TRAP ? 'T' : ' ', flags & EFFECT_INDIRECT ? 'I' : ' ', flags & EFFECT_RECURSIVE ? 'R' : ' ',
+			flags & (EFFECT_READS_MEMORY | EFFECT_WRITES_MEMORY) ? 'P' : ' ',
+			reads->count, writes->count, function_name(functions[f].start));
+		if (reads->count) {
+			out_puts(h, "    reads:");
+			for (int i = 0; i < reads->count; i++)
+				out_printf(h, " %s", globalrefs[reads->items[i]].symbol->symbol);
+			out_puts(h, "\n");
+		}
+		if (writes->count) {
+			out_puts(h, "    writes:");
+			for (int i = 0; i < writes->count; i++)
+				out_printf(h, " %s", globalrefs[writes->items[i]].symbol->symbol);
+			out_puts(h, "\n");
+		}
+	}
+
+	free_effects();
+}
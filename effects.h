@@ -0,0 +1,43 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_EFFECTS_H
+#define QVMOPS_EFFECTS_H
+
+#include "qvm.h"
+#include "output.h"
+
+// side effects of a function, including everything it calls
+#define EFFECT_READS_GLOBAL		0x01	// loads from a DATA/BSS global (LIT is constant)
+#define EFFECT_WRITES_GLOBAL	0x02	// stores or copies to a global
+#define EFFECT_READS_MEMORY		0x04	// loads through a pointer that isn't a local or global address
+#define EFFECT_WRITES_MEMORY	0x08	// stores or copies through such a pointer
+#define EFFECT_TRAP				0x10	// calls a system call
+#define EFFECT_INDIRECT			0x20	// calls through a function pointer (could do anything)
+#define EFFECT_RECURSIVE		0x40	// part of a call cycle
+
+// a function is pure (its result only depends on its arguments) without any of these
+#define EFFECT_IMPURE	(EFFECT_READS_GLOBAL | EFFECT_WRITES_GLOBAL | EFFECT_READS_MEMORY | EFFECT_WRITES_MEMORY | EFFECT_TRAP | EFFECT_INDIRECT)
+// and only reads memory without any of these
+#define EFFECT_WRITES	(EFFECT_WRITES_GLOBAL | EFFECT_WRITES_MEMORY | EFFECT_TRAP | EFFECT_INDIRECT)
+
+// EFFECT_ flags of each function (filled by find_effects)
+extern int effectflags[MAX_FUNCTIONS];
+
+// find each function's own loads, stores and calls, then combine them bottom-up over the call graph's
+// strongly connected components (so each function's summary includes its callees)
+void find_effects(void);
+
+// output each function's summary, with the globals it reads and writes
+void report_effects(output_t* h);
+
+#endif // QVMOPS_EFFECTS_H
@@ -0,0 +1,274 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "analysis.h"
+#include "rewrite.h"
+#include "jumptable.h"
+#include "globals.h"
+
+globalrefs_t globalrefs[SEGMENT_COUNT * MAX_SYMBOLS];
+int globalcount;
+
+// a value on the operand stack: a static data address (possibly plus an unknown offset), or nothing known
+#define GLOBAL_STACK_SIZE 64
+typedef struct globalval_s {
+	int known;			// value is a data address
+	int exact;			// value is exactly address, not address plus an unknown offset
+	int address;
+} globalval_t;
+typedef struct globalstack_s {
+	globalval_t values[GLOBAL_STACK_SIZE];
+	int depth;
+} globalstack_t;
+
+
+static void global_push(globalstack_t* stack, int known, int exact, int address) {
+	// drop the bottom of the stack rather than overflow
+	if (stack->depth == GLOBAL_STACK_SIZE) {
+		memmove(stack->values, stack->values + 1, (GLOBAL_STACK_SIZE - 1) * sizeof(globalval_t));
+		stack->depth--;
+	}
+	stack->values[stack->depth].known = known;
+	stack->values[stack->depth].exact = exact;
+	stack->values[stack->depth].address = address;
+	stack->depth++;
+}
+
+
+static globalval_t global_pop(globalstack_t* stack) {
+	globalval_t unknown = { 0, 0, 0 };
+	if (!stack->depth)
+		return unknown;
+	return stack->values[--stack->depth];
+}
+
+
+// sort by address
+static int compare_address(const void* a, const void* b) {
+	const globalrefs_t* ga = (const globalrefs_t*)a;
+	const globalrefs_t* gb = (const globalrefs_t*)b;
+	return ga->address - gb->address;
+}
+
+
+// find the symbol containing a data address
+globalrefs_t* find_global(int address) {
+	int lo = 0;
+	int hi = globalcount - 1;
+
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		globalrefs_t* global = &globalrefs[mid];
+		if (address < global->address)
+			hi = mid - 1;
+		else if (address >= global->address + global->size)
+			lo = mid + 1;
+		else
+			return global;
+	}
+	return NULL;
+}
+
+
+// count a load/store/block copy of a value
+static void global_access(globalval_t value, int write) {
+	globalrefs_t* global;
+
+	if (!value.known || !(global = find_global(value.address)))
+		return;
+	if (write)
+		global->writes++;
+	else
+		global->reads++;
+}
+
+
+// count an address that is used in a way that can't be followed
+// a bare constant only counts at a symbol's address, since small integer constants look just like addresses near
+// the start of DATA, but an address plus an offset or index (p = &arr[i]) counts for the global it is based in
+static void global_escape(globalval_t value) {
+	globalrefs_t* global;
+
+	if (!value.known || !(global = find_global(value.address)) || (value.exact && global->address != value.address))
+		return;
+	global->escapes++;
+}
+
+
+// fill globalrefs array from the map's data symbols and the static addresses used in code and data
+void find_global_refs(void) {
+	int total = datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT] + datasize[SEGMENT_BSS];
+	globalstack_t stack;
+	uint8_t* entry;
+
+	globalcount = 0;
+	for (int segment = SEGMENT_DATA; segment <= SEGMENT_BSS; segment++) {
+		for (int i = 0; i < symbolcount[segment]; i++) {
+			symbolmap_t* symbol = &symbols[segment][i];
+			globalrefs_t* global = &globalrefs[globalcount];
+			// the program stack is used without being referenced
+			if (!strncmp(symbol->symbol, "_stack", 6))
+				continue;
+			memset(global, 0, sizeof(*global));
+			global->symbol = symbol;
+			global->address = data_symbol_address(symbol);
+			global->size = data_symbol_size(symbol);
+			if (global->size > 0)
+				globalcount++;
+		}
+	}
+	qsort(globalrefs, globalcount, sizeof(globalrefs_t), compare_address);
+
+	// values reaching a jump target may come from elsewhere
+	entry = (uint8_t*)calloc(instructioncount + 1, 1);
+	if (!entry) {
+		fprintf(stderr, "Unable to allocate global reference memory\n");
+		return;
+	}
+	for (int index = 0; index < instructioncount; index++) {
+		int target = branch_target(index);
+		if (target >= 0 && target < instructioncount)
+			entry[target] = 1;
+	}
+	for (int t = 0; t < jumptablecount; t++) {
+		for (int i = 0; i < jumptables[t].count; i++)
+			entry[jumptable_target(&jumptables[t], i)] = 1;
+	}
+
+	stack.depth = 0;
+	for (int index = 0; index < instructioncount; index++) {
+		instruction_t* instr = &instructions[index];
+		globalval_t a, b;
+		int pops, pushes;
+
+		if (entry[index] || instr->opcode == OP_ENTER)
+			stack.depth = 0;
+
+		switch (instr->opcode) {
+		case OP_CONST:
+			global_push(&stack, !is_code_ref(index) && instr->param >= 0 && instr->param < total, 1, instr->param);
+			break;
+		case OP_ADD:
+		case OP_SUB:
+			// an address plus or minus an index is still in the same global (as far as can be told)
+			b = global_pop(&stack);
+			a = global_pop(&stack);
+			if (a.known && b.known && instr->opcode == OP_ADD)
+				global_push(&stack, 1, 0, a.exact && b.exact ? a.address + b.address : a.address);
+			else if (a.known)
+				global_push(&stack, 1, 0, a.address);
+			else if (b.known && instr->opcode == OP_ADD)
+				global_push(&stack, 1, 0, b.address);
+			else
+				global_push(&stack, 0, 0, 0);
+			break;
+		case OP_LOAD1:
+		case OP_LOAD2:
+		case OP_LOAD4:
+			global_access(global_pop(&stack), 0);
+			global_push(&stack, 0, 0, 0);
+			break;
+		case OP_STORE1:
+		case OP_STORE2:
+		case OP_STORE4:
+			global_escape(global_pop(&stack));
+			global_access(global_pop(&stack), 1);
+			break;
+		case OP_BLOCK_COPY:
+			b = global_pop(&stack);
+			a = global_pop(&stack);
+			global_access(b, 0);
+			global_access(a, 1);
+			break;
+		case OP_ARG:
+		case OP_LEAVE:
+			global_escape(global_pop(&stack));
+			break;
+		default:
+			opcodestack(instr->opcode, &pops, &pushes);
+			while (pops--)
+				global_pop(&stack);
+			while (pushes--)
+				global_push(&stack, 0, 0, 0);
+		}
+
+		if (instr->opcode == OP_JUMP || instr->opcode == OP_LEAVE)
+			stack.depth = 0;
+	}
+	free(entry);
+
+	// pointers in initialized data (string tables, arrays of structs pointing at other globals)
+	for (int address = 0; address + 4 <= datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT]; address += 4) {
+		globalval_t value = { 1, 1, 0 };
+		memcpy(&value.address, data + address, sizeof(int));
+		if (value.address > 0 && value.address < total)
+			global_escape(value);
+	}
+}
+
+
+// sort by size, largest first
+static int compare_size(const void* a, const void* b) {
+	const globalrefs_t* ga = *(const globalrefs_t**)a;
+	const globalrefs_t* gb = *(const globalrefs_t**)b;
+	if (ga->size != gb->size)
+		return gb->size - ga->size;
+	return ga->address - gb->address;
+}
+
+
+// output globals that are never referenced or only written, sorted by size
+void report_globals(output_t* h) {
+	static const char* segmentnames[SEGMENT_COUNT] = { "CODE", "DATA", "LIT", "BSS" };
+	globalrefs_t** sorted;
+	int count = 0;
+	int unused[SEGMENT_COUNT] = { 0, };
+	int writeonly[SEGMENT_COUNT] = { 0, };
+
+	puts("Processing unused globals report...");
+
+	find_global_refs();
+
+	sorted = (globalrefs_t**)malloc((globalcount ? globalcount : 1) * sizeof(globalrefs_t*));
+	if (!sorted) {
+		fprintf(stderr, "Unable to allocate global report memory\n");
+		return;
+	}
+	for (int i = 0; i < globalcount; i++) {
+		globalrefs_t* global = &globalrefs[i];
+		if (global->reads || global->escapes)
+			continue;
+		if (global->writes)
+			writeonly[global->symbol->segment] += global->size;
+		else
+			unused[global->symbol->segment] += global->size;
+		sorted[count++] = global;
+	}
+	qsort(sorted, count, sizeof(globalrefs_t*), compare_size);
+
+	out_puts(h, "\n\nUNUSED GLOBALS\n==============\n");
+	out_puts(h, "Globals whose address is never loaded from, passed, returned or stored (only static addresses in code and data are seen)\n");
+	out_printf(h, "Never referenced: DATA %d, LIT %d, BSS %d bytes\n", unused[SEGMENT_DATA], unused[SEGMENT_LIT], unused[SEGMENT_BSS]);
+	out_printf(h, "Only written:     DATA %d, LIT %d, BSS %d bytes\n", writeonly[SEGMENT_DATA], writeonly[SEGMENT_LIT], writeonly[SEGMENT_BSS]);
+	out_printf(h, "%8s %-7s %8s %-12s %s\n", "SIZE", "SEGMENT", "ADDRESS", "STATUS", "SYMBOL");
+	for (int i = 0; i < count; i++) {
+		globalrefs_t* global = sorted[i];
+		out_printf(h, "%8d %-7s %8X %-12s %s\n", global->size, segmentnames[global->symbol->segment], global->address,
+			global->writes ? "only written" : "unused", global->symbol->symbol);
+	}
+
+	free(sorted);
+}
@@ -0,0 +1,40 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_GLOBALS_H
+#define QVMOPS_GLOBALS_H
+
+#include "output.h"
+#include "symbols.h"
+
+// static references to a DATA/LIT/BSS symbol
+typedef struct globalrefs_s {
+	symbolmap_t* symbol;
+	int address;		// absolute data address
+	int size;
+	int reads;			// loads and block copy sources
+	int writes;			// stores and block copy destinations
+	int escapes;		// address passed to a call, returned, stored, or in initialized data
+} globalrefs_t;
+extern globalrefs_t globalrefs[SEGMENT_COUNT * MAX_SYMBOLS];
+extern int globalcount;
+
+// fill globalrefs array from the map's data symbols and the static addresses used in code and data
+void find_global_refs(void);
+
+// find the symbol containing a data address (after find_global_refs)
+globalrefs_t* find_global(int address);
+
+// output globals that are never referenced or only written, sorted by size
+void report_globals(output_t* h);
+
+#endif // QVMOPS_GLOBALS_H
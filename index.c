@@ -0,0 +1,146 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "index.h"
+
+static indexheader_t indexheader;
+static indexcheckpoint_t* checkpoints;
+static int checkpointsize;
+static indexfunction_t* indexfuncs;
+static int indexfuncsize;
+static char* strings;
+static int stringalloc;
+static int outofmemory;
+
+
+// grow an array to hold at least count elements
+static void* grow(void* array, int* size, int count, size_t elemsize) {
+	void* grown;
+	int newsize;
+
+	if (count <= *size)
+		return array;
+	newsize = *size ? *size * 2 : 1024;
+	while (newsize < count)
+		newsize *= 2;
+	grown = realloc(array, newsize * elemsize);
+	if (!grown) {
+		outofmemory = 1;
+		return array;
+	}
+	*size = newsize;
+	return grown;
+}
+
+
+// start a new index, at the position of the first instruction line
+void index_begin(int64_t pos) {
+	memset(&indexheader, 0, sizeof(indexheader));
+	indexheader.magic = INDEX_MAGIC;
+	indexheader.version = INDEX_VERSION;
+	indexheader.instructioncount = instructioncount;
+	indexheader.interval = INDEX_INTERVAL;
+	indexheader.qvmcrc = qvmcrc;
+	indexheader.codecrc = codecrc;
+	indexheader.codepos = pos;
+	indexheader.codeend = pos;
+	outofmemory = 0;
+}
+
+
+// note the position of an instruction line (only checkpoints are kept)
+void index_instruction(int index, int64_t pos) {
+	indexcheckpoint_t* checkpoint;
+
+	if (index % INDEX_INTERVAL)
+		return;
+
+	checkpoints = (indexcheckpoint_t*)grow(checkpoints, &checkpointsize, indexheader.checkpointcount + 1, sizeof(indexcheckpoint_t));
+	if (indexheader.checkpointcount >= checkpointsize)
+		return;
+	checkpoint = &checkpoints[indexheader.checkpointcount++];
+	checkpoint->index = index;
+	checkpoint->offset = get_instruction(index)->offset;
+	checkpoint->pos = pos;
+}
+
+
+// note the position of the OP_ENTER line of a function
+void index_function(int index, int64_t pos) {
+	function_t* func = find_function(index);
+	indexfunction_t* entry;
+	const char* name = function_name(index);
+	int len = (int)strlen(name) + 1;
+
+	indexfuncs = (indexfunction_t*)grow(indexfuncs, &indexfuncsize, indexheader.functioncount + 1, sizeof(indexfunction_t));
+	strings = (char*)grow(strings, &stringalloc, indexheader.stringsize + len, 1);
+	if (indexheader.functioncount >= indexfuncsize || indexheader.stringsize + len > stringalloc)
+		return;
+
+	entry = &indexfuncs[indexheader.functioncount++];
+	entry->start = index;
+	entry->end = func ? func->end : index + 1;
+	entry->pos = pos;
+	entry->name = indexheader.stringsize;
+	entry->reserved = 0;
+	memcpy(strings + indexheader.stringsize, name, len);
+	indexheader.stringsize += len;
+}
+
+
+// note the position after the last instruction line
+void index_end(int64_t pos) {
+	indexheader.codeend = pos;
+}
+
+
+// write the index to a file and free it
+int index_write(const char* file) {
+	FILE* h;
+	int ok = 0;
+
+	if (outofmemory) {
+		fprintf(stderr, "Unable to allocate index memory\n");
+		goto done;
+	}
+
+	printf("Writing %s...\n", file);
+
+	h = fopen(file, "wb");
+	if (!h) {
+		fprintf(stderr, "Unable to open %s for writing\n", file);
+		goto done;
+	}
+	fwrite(&indexheader, sizeof(indexheader), 1, h);
+	fwrite(checkpoints, sizeof(indexcheckpoint_t), indexheader.checkpointcount, h);
+	fwrite(indexfuncs, sizeof(indexfunction_t), indexheader.functioncount, h);
+	fwrite(strings, 1, indexheader.stringsize, h);
+	ok = !ferror(h);
+	fclose(h);
+	if (!ok)
+		fprintf(stderr, "Error writing %s\n", file);
+
+done:
+	free(checkpoints);
+	free(indexfuncs);
+	free(strings);
+	checkpoints = NULL;
+	indexfuncs = NULL;
+	strings = NULL;
+	checkpointsize = indexfuncsize = stringalloc = 0;
+	return ok;
+}
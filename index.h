@@ -0,0 +1,74 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_INDEX_H
+#define QVMOPS_INDEX_H
+
+#include <stdint.h>
+
+// magic number at start of .idx files ("QIDX")
+#define INDEX_MAGIC		0x58444951
+#define INDEX_VERSION	2
+// a checkpoint is recorded for every instruction index that is a multiple of this
+#define INDEX_INTERVAL	16
+
+// .idx file layout (little endian):
+//   indexheader_t
+//   indexcheckpoint_t[checkpointcount], by instruction index
+//   indexfunction_t[functioncount], by instruction index
+//   stringsize bytes of null-terminated function names
+// positions are byte offsets into the (uncompressed) disassembly text, at the start of the instruction's line
+typedef struct indexheader_s {
+	uint32_t magic;
+	uint32_t version;
+	int32_t instructioncount;	// in the whole qvm
+	int32_t interval;			// INDEX_INTERVAL
+	int32_t checkpointcount;
+	int32_t functioncount;
+	int32_t stringsize;
+	uint32_t qvmcrc;			// CRC-32 of the whole qvm the disassembly is of
+	uint32_t codecrc;			// CRC-32 of its code segment
+	int32_t reserved;
+	int64_t codepos;			// position of the first instruction line
+	int64_t codeend;			// position after the last instruction line
+} indexheader_t;
+
+typedef struct indexcheckpoint_s {
+	int32_t index;				// instruction index
+	int32_t offset;				// code segment byte offset
+	int64_t pos;
+} indexcheckpoint_t;
+
+typedef struct indexfunction_s {
+	int32_t start;				// instruction index of OP_ENTER
+	int32_t end;				// instruction index after the last instruction
+	int64_t pos;
+	int32_t name;				// offset of name in string table
+	int32_t reserved;
+} indexfunction_t;
+
+// start a new index, at the position of the first instruction line
+void index_begin(int64_t pos);
+
+// note the position of an instruction line (only checkpoints are kept)
+void index_instruction(int index, int64_t pos);
+
+// note the position of the OP_ENTER line of a function
+void index_function(int index, int64_t pos);
+
+// note the position after the last instruction line
+void index_end(int64_t pos);
+
+// write the index to a file and free it
+int index_write(const char* file);
+
+#endif // QVMOPS_INDEX_H
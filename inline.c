@@ -0,0 +1,222 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "analysis.h"
+#include "rewrite.h"
+#include "inline.h"
+
+uint8_t inlinable[MAX_FUNCTIONS];
+
+// a call site chosen for inlining
+typedef struct inlinesite_s {
+	int index;			// instruction index of the OP_CONST before the OP_CALL
+	int callee;			// function number
+	int depth;			// loop depth, hottest sites are inlined first
+} inlinesite_t;
+
+static uint8_t* inlinesite;		// is the OP_CONST at each instruction an inlined call
+
+
+// mark leaf functions that can be substituted at their call sites
+void find_inlinable(int maxbody) {
+	memset(inlinable, 0, functioncount);
+
+	// vmMain is only ever called by the engine
+	for (int f = 1; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		int ok = 1;
+
+		if (func->end - func->start - 2 > maxbody || func->end - func->start < 2)
+			continue;
+		if (instructions[func->end - 1].opcode != OP_LEAVE)
+			continue;
+
+		for (int index = func->start + 1; index < func->end - 1 && ok; index++) {
+			instruction_t* instr = &instructions[index];
+			int target;
+			switch (instr->opcode) {
+			case OP_CALL:
+			case OP_LEAVE:
+			case OP_ENTER:
+			case OP_ARG:
+				ok = 0;
+				break;
+			case OP_JUMP:
+				// only constant jumps within the function can be re-pointed in each copy
+				target = branch_target(index);
+				ok = target > func->start && target < func->end;
+				break;
+			case OP_CONST:
+				// a function pointer, or a jump that's checked at the OP_JUMP
+				if (is_code_ref(index) && instructions[index + 1].opcode != OP_JUMP)
+					ok = 0;
+				break;
+			default:
+				if (is_branch(instr->opcode)) {
+					target = branch_target(index);
+					ok = target > func->start && target < func->end;
+				}
+			}
+		}
+		inlinable[f] = (uint8_t)ok;
+	}
+}
+
+
+static int compare_sites(const void* a, const void* b) {
+	const inlinesite_t* sa = (const inlinesite_t*)a;
+	const inlinesite_t* sb = (const inlinesite_t*)b;
+	if (sa->depth != sb->depth)
+		return sa->depth > sb->depth ? -1 : 1;
+	return sa->index < sb->index ? -1 : 1;
+}
+
+
+// new param for an instruction of an inlined body
+// locals move to the space added to the caller's frame (above the caller's own locals), parameters are read
+// straight from where the caller's OP_ARGs stored them, and branches stay within this copy of the body
+static int inline_param(function_t* callee, int index, int callerframe, int base) {
+	instruction_t* instr = &instructions[index];
+
+	if (instr->opcode == OP_LOCAL) {
+		if (instr->param >= callee->framesize)
+			return instr->param - callee->framesize;
+		return callerframe + instr->param;
+	}
+	if (is_branch(instr->opcode) || (instr->opcode == OP_CONST && is_code_ref(index)))
+		return base + instr->param - (callee->start + 1);
+	return instr->param;
+}
+
+
+// write a copy of the loaded qvm (and map) with calls to small leaf functions replaced by their bodies
+int inline_qvm(const char* qvmfile, const char* mapfile, int maxbody, int maxgrowth) {
+	inlinesite_t* sites = NULL;
+	int sitecount = 0;
+	int budget = (int)((int64_t)instructioncount * maxgrowth / 100);
+	int growth = 0;
+	int inlined = 0;
+	int ok = 0;
+
+	puts("Processing inlining...");
+
+	find_inlinable(maxbody);
+	find_loops();
+
+	sites = (inlinesite_t*)malloc((instructioncount + 1) * sizeof(inlinesite_t));
+	inlinesite = (uint8_t*)calloc(instructioncount + 1, 1);
+	if (!sites || !inlinesite) {
+		fprintf(stderr, "Unable to allocate inline memory\n");
+		goto done;
+	}
+
+	// find every direct call of an inlinable function, but not where a branch lands on the OP_CALL itself
+	for (int index = 0; index < instructioncount; index++) {
+		int target = branch_target(index);
+		if (target > 0 && instructions[target].opcode == OP_CALL)
+			inlinesite[target - 1] = 1;
+	}
+	for (int index = 0; index + 1 < instructioncount; index++) {
+		function_t* callee;
+		if (instructions[index].opcode != OP_CONST || instructions[index + 1].opcode != OP_CALL || instructions[index].param <= 0)
+			continue;
+		if (inlinesite[index])
+			continue;
+		callee = find_function(instructions[index].param);
+		if (!callee || callee->start != instructions[index].param || !inlinable[callee - functions])
+			continue;
+		if (find_function(index) == callee)
+			continue;
+		sites[sitecount].index = index;
+		sites[sitecount].callee = (int)(callee - functions);
+		sites[sitecount].depth = loopdepth[index];
+		sitecount++;
+	}
+
+	// hottest sites first, until the code has grown by the budget
+	memset(inlinesite, 0, instructioncount + 1);
+	qsort(sites, sitecount, sizeof(inlinesite_t), compare_sites);
+	for (int i = 0; i < sitecount; i++) {
+		function_t* callee = &functions[sites[i].callee];
+		int size = callee->end - callee->start - 2;
+		if (growth + size - 2 > budget)
+			continue;
+		growth += size - 2;
+		inlinesite[sites[i].index] = 1;
+	}
+
+	if (!rewrite_begin())
+		goto done;
+
+	// anything before the first function (there shouldn't be anything) is kept
+	if (functioncount)
+		rewrite_copy(0, functions[0].start);
+
+	for (int f = 0; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		int extra = 0;
+
+		// the caller's frame grows by the largest inlined frame, which all inlined bodies share
+		for (int index = func->start; index < func->end; index++) {
+			if (inlinesite[index]) {
+				function_t* callee = find_function(instructions[index].param);
+				if (callee->framesize > extra)
+					extra = callee->framesize;
+			}
+		}
+
+		for (int index = func->start; index < func->end; index++) {
+			instruction_t* instr = &instructions[index];
+			if (inlinesite[index]) {
+				function_t* callee = find_function(instr->param);
+				int base = newcount;
+				printf("Inlining %s into %s+%d (%d instructions)\n", function_name(callee->start),
+					function_name(func->start), index - func->start, callee->end - callee->start - 2);
+				remap[index] = newcount;
+				for (int i = callee->start + 1; i < callee->end - 1; i++)
+					rewrite_emit(instructions[i].opcode, inline_param(callee, i, func->framesize, base));
+				// skip the OP_CALL too
+				index++;
+				inlined++;
+				continue;
+			}
+			rewrite_copy(index, index + 1);
+			if (!extra)
+				continue;
+			// the added space goes between the caller's locals and its own parameters
+			if (instr->opcode == OP_ENTER || instr->opcode == OP_LEAVE)
+				newcode[newcount - 1].param += extra;
+			else if (instr->opcode == OP_LOCAL && instr->param >= func->framesize)
+				newcode[newcount - 1].param += extra;
+		}
+	}
+
+	ok = rewrite_finish();
+	if (ok)
+		ok = write_qvm(qvmfile) && write_map(mapfile);
+
+	printf("Inlined %d of %d call sites, %d instructions added\n", inlined, sitecount, growth);
+
+	rewrite_end();
+
+done:
+	free(sites);
+	free(inlinesite);
+	inlinesite = NULL;
+	return ok;
+}
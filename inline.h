@@ -0,0 +1,33 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_INLINE_H
+#define QVMOPS_INLINE_H
+
+#include "qvm.h"
+
+// default largest function body (excluding OP_ENTER/OP_LEAVE) that may be inlined
+#define INLINE_MAX_BODY		16
+// default growth of the code segment allowed, in percent of its instruction count
+#define INLINE_MAX_GROWTH	10
+
+// can each function be inlined (filled by find_inlinable)
+extern uint8_t inlinable[MAX_FUNCTIONS];
+
+// mark leaf functions that can be substituted at their call sites: no calls, a single OP_LEAVE at the end,
+// no computed jumps or function pointers, and a body of at most maxbody instructions
+void find_inlinable(int maxbody);
+
+// write a copy of the loaded qvm (and map) with calls to small leaf functions replaced by their bodies
+int inline_qvm(const char* qvmfile, const char* mapfile, int maxbody, int maxgrowth);
+
+#endif // QVMOPS_INLINE_H
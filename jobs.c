@@ -0,0 +1,96 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include "jobs.h"
+
+
+// run func for every jobs'th item starting at first
+static int run_items(int first, int jobs, int count, jobfunc_t func, int failfast) {
+	int ret = 1;
+
+	for (int item = first; item < count; item += jobs) {
+		if (!func(item)) {
+			ret = 0;
+			if (failfast)
+				break;
+		}
+	}
+
+	return ret;
+}
+
+
+// run func for items 0 through count-1, spread over up to jobs worker processes
+// each worker stops at its first failure if failfast is set
+// returns 0 if any item failed
+int run_jobs(int jobs, int count, jobfunc_t func, int failfast) {
+#ifdef _WIN32
+	// no fork(), so items are just processed in order
+	(void)jobs;
+	return run_items(0, 1, count, func, failfast);
+#else
+	int started = 0;
+	int ret = 1;
+
+	if (jobs > count)
+		jobs = count;
+	if (jobs <= 1)
+		return run_items(0, 1, count, func, failfast);
+
+	// anything still buffered would be written by every worker
+	fflush(stdout);
+	fflush(stderr);
+
+	for (int job = 0; job < jobs; job++) {
+		pid_t pid = fork();
+		if (pid < 0) {
+			fprintf(stderr, "Unable to start worker process: %s\n", strerror(errno));
+			// do the rest of the work here instead
+			if (!run_items(job, jobs, count, func, failfast))
+				ret = 0;
+			continue;
+		}
+		if (!pid) {
+			// keep lines from different workers whole
+			setvbuf(stdout, NULL, _IOLBF, 0);
+			ret = run_items(job, jobs, count, func, failfast);
+			fflush(stdout);
+			fflush(stderr);
+			_exit(ret ? 0 : 1);
+		}
+		started++;
+	}
+
+	while (started > 0) {
+		int status;
+		pid_t pid = wait(&status);
+		if (pid < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		started--;
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			ret = 0;
+	}
+
+	return ret;
+#endif
+}
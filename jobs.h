@@ -0,0 +1,24 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_JOBS_H
+#define QVMOPS_JOBS_H
+
+// a job to run for each item, returns 0 on failure
+typedef int (*jobfunc_t)(int item);
+
+// run func for items 0 through count-1, spread over up to jobs worker processes
+// each worker stops at its first failure if failfast is set
+// returns 0 if any item failed
+int run_jobs(int jobs, int count, jobfunc_t func, int failfast);
+
+#endif // QVMOPS_JOBS_H
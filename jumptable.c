@@ -0,0 +1,265 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "qvm.h"
+#include "analysis.h"
+#include "jumptable.h"
+
+jumptable_t jumptables[MAX_JUMPTABLES];
+int jumptablecount;
+
+// jumptables indexes sorted by address
+static int byaddress[MAX_JUMPTABLES];
+
+// how far back from the table load to look for the range checks
+#define JUMPTABLE_SEARCH	32
+
+
+// first instruction of the expression that leaves one value on the stack, ending at end (inclusive)
+// returns -1 if it would start before the limit
+static int expression_start(int end, int limit) {
+	int need = 1;
+
+	for (int index = end; index >= limit; index--) {
+		int pops, pushes;
+		opcodestack(get_instruction(index)->opcode, &pops, &pushes);
+		need += pops - pushes;
+		if (need <= 0)
+			return need == 0 ? index : -1;
+	}
+	return -1;
+}
+
+
+// do two instruction ranges hold the same code
+static int same_code(int a, int b, int len) {
+	for (int i = 0; i < len; i++) {
+		if (get_instruction(a + i)->opcode != get_instruction(b + i)->opcode || get_instruction(a + i)->param != get_instruction(b + i)->param)
+			return 0;
+	}
+	return 1;
+}
+
+
+// is this a constant scale by 4: CONST 2; LSH or CONST 4; MULI/MULU
+static int is_scale4(int index) {
+	vmop_t op = get_instruction(index)->opcode;
+	int c;
+
+	if (get_instruction(index - 1)->opcode != OP_CONST)
+		return 0;
+	c = get_instruction(index - 1)->param;
+	return (op == OP_LSH && c == 2) || ((op == OP_MULI || op == OP_MULU) && c == 4);
+}
+
+
+// look backwards from start for the range checks on the value computed by [value, value + len)
+// fills lo/hi (inclusive) and the default target of each found
+static void find_range_checks(int start, int value, int len, int limit, int* lo, int* hi, int* fallback, int* haslo, int* hashi) {
+	for (int index = start - 1; index - 1 - len >= limit && index >= start - JUMPTABLE_SEARCH; index--) {
+		vmop_t op = get_instruction(index)->opcode;
+		int k;
+
+		if (!is_branch(op) || get_instruction(index - 1)->opcode != OP_CONST)
+			continue;
+		if (!same_code(index - 1 - len, value, len))
+			continue;
+		k = get_instruction(index - 1)->param;
+
+		switch (op) {
+		case OP_LTI:
+			*lo = k;
+			*haslo = 1;
+			break;
+		case OP_LEI:
+			*lo = k + 1;
+			*haslo = 1;
+			break;
+		case OP_GTI:
+			*hi = k;
+			*hashi = 1;
+			break;
+		case OP_GEI:
+			*hi = k - 1;
+			*hashi = 1;
+			break;
+		case OP_GTU:
+			// an unsigned check also rules out negative values
+			*hi = k;
+			*hashi = 1;
+			if (!*haslo) {
+				*lo = 0;
+				*haslo = 1;
+			}
+			break;
+		default:
+			continue;
+		}
+		*fallback = get_instruction(index)->param;
+	}
+}
+
+
+// try to recover the table of the computed OP_JUMP at index
+static int recover_jumptable(int jump, jumptable_t* table) {
+	function_t* func = find_function(jump);
+	int add = jump - 2;
+	int scale, value, valueend, base, baseindex;
+	int offset = 0;
+	int lo = 0, hi = 0, haslo = 0, hashi = 0;
+	int fallback = -1;
+	int64_t first, last;
+
+	if (!func || add - 3 <= func->start)
+		return 0;
+	if (get_instruction(jump - 1)->opcode != OP_LOAD4 || get_instruction(add)->opcode != OP_ADD)
+		return 0;
+
+	// either "index * 4; CONST table; ADD" or "CONST table; index * 4; ADD"
+	if (get_instruction(add - 1)->opcode == OP_CONST && is_scale4(add - 2)) {
+		baseindex = add - 1;
+		scale = add - 2;
+		valueend = scale - 2;
+		value = expression_start(valueend, func->start + 1);
+	}
+	else if (is_scale4(add - 1)) {
+		scale = add - 1;
+		valueend = scale - 2;
+		value = expression_start(valueend, func->start + 1);
+		baseindex = value - 1;
+		if (value < 0 || get_instruction(baseindex)->opcode != OP_CONST)
+			return 0;
+	}
+	else
+		return 0;
+	if (value < 0)
+		return 0;
+	base = get_instruction(baseindex)->param;
+
+	// the range checks are either on the index itself or on the switch value before "CONST lo; SUB"
+	find_range_checks(value, value, valueend - value + 1, func->start + 1, &lo, &hi, &fallback, &haslo, &hashi);
+	if ((!haslo || !hashi) && valueend - value >= 2 && get_instruction(valueend)->opcode == OP_SUB && get_instruction(valueend - 1)->opcode == OP_CONST) {
+		offset = get_instruction(valueend - 1)->param;
+		haslo = hashi = 0;
+		find_range_checks(value, value, valueend - value - 1, func->start + 1, &lo, &hi, &fallback, &haslo, &hashi);
+		lo -= offset;
+		hi -= offset;
+	}
+	if (!haslo || !hashi || lo > hi)
+		return 0;
+
+	// the entries must all be in initialized data and point into this function
+	first = (int64_t)base + (int64_t)lo * 4;
+	last = (int64_t)base + (int64_t)hi * 4 + 4;
+	if (first < 0 || (first & 3) || last > datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT])
+		return 0;
+
+	table->jump = jump;
+	table->address = (int)first;
+	table->count = hi - lo + 1;
+	table->first = lo + offset;
+	table->fallback = fallback;
+
+	for (int i = 0; i < table->count; i++) {
+		int target = jumptable_target(table, i);
+		if (target <= func->start || target >= func->end)
+			return 0;
+	}
+	return 1;
+}
+
+
+static int compare_address(const void* a, const void* b) {
+	const jumptable_t* ta = &jumptables[*(const int*)a];
+	const jumptable_t* tb = &jumptables[*(const int*)b];
+	if (ta->address != tb->address)
+		return ta->address < tb->address ? -1 : 1;
+	return 0;
+}
+
+
+// recognize lcc's switch pattern at each computed OP_JUMP and fill jumptables
+void find_jumptables(void) {
+	jumptablecount = 0;
+
+	for (int index = 1; index < instructioncount && jumptablecount < MAX_JUMPTABLES; index++) {
+		if (get_instruction(index)->opcode != OP_JUMP || get_instruction(index - 1)->opcode == OP_CONST)
+			continue;
+		if (recover_jumptable(index, &jumptables[jumptablecount]))
+			jumptablecount++;
+	}
+
+	for (int i = 0; i < jumptablecount; i++)
+		byaddress[i] = i;
+	qsort(byaddress, jumptablecount, sizeof(int), compare_address);
+}
+
+
+// the jump table used by the OP_JUMP at an instruction index, or NULL
+jumptable_t* find_jumptable(int index) {
+	static jumptable_t lazytable;
+	int lo = 0;
+	int hi = jumptablecount - 1;
+
+	// in lazy mode tables aren't found up front, so recover this one from the instructions around it
+	if (lazydecode) {
+		if (get_instruction(index)->opcode != OP_JUMP || get_instruction(index - 1)->opcode == OP_CONST)
+			return NULL;
+		return recover_jumptable(index, &lazytable) ? &lazytable : NULL;
+	}
+
+	// tables are found in code order
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		if (jumptables[mid].jump == index)
+			return &jumptables[mid];
+		if (jumptables[mid].jump < index)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return NULL;
+}
+
+
+// the jump table containing a data address, or NULL
+jumptable_t* find_jumptable_by_address(int address) {
+	int lo = 0;
+	int hi = jumptablecount - 1;
+
+	// find the last table that starts at or before address
+	if (!jumptablecount || address < jumptables[byaddress[0]].address)
+		return NULL;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		if (jumptables[byaddress[mid]].address <= address)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	if (address >= jumptables[byaddress[lo]].address + jumptables[byaddress[lo]].count * 4)
+		return NULL;
+	return &jumptables[byaddress[lo]];
+}
+
+
+// instruction index of a jump table entry
+int jumptable_target(const jumptable_t* table, int entry) {
+	int target;
+	memcpy(&target, data + table->address + entry * 4, sizeof(int));
+	return target;
+}
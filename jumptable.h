@@ -0,0 +1,45 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_JUMPTABLE_H
+#define QVMOPS_JUMPTABLE_H
+
+#include "qvm.h"
+
+#define MAX_JUMPTABLES 10000
+// a switch statement's jump table, found from the code around a computed OP_JUMP
+typedef struct jumptable_s {
+	int jump;			// instruction index of the OP_JUMP
+	int address;		// data address of the first entry
+	int count;			// number of entries
+	int first;			// switch value of the first entry
+	int fallback;		// instruction index of the default case (where out of range values go), or -1
+} jumptable_t;
+extern jumptable_t jumptables[MAX_JUMPTABLES];
+extern int jumptablecount;
+
+// recognize lcc's switch pattern at each computed OP_JUMP:
+//   value; CONST lo; LTI default; value; CONST hi; GTI default; value; CONST 2; LSH; CONST table; ADD; LOAD4; JUMP
+// and fill jumptables with those whose entries are all instruction indexes in the same function
+void find_jumptables(void);
+
+// the jump table used by the OP_JUMP at an instruction index, or NULL
+// in lazy mode it is recovered on demand, and only good until the next call
+jumptable_t* find_jumptable(int index);
+
+// the jump table containing a data address, or NULL
+jumptable_t* find_jumptable_by_address(int address);
+
+// instruction index of a jump table entry
+int jumptable_target(const jumptable_t* table, int entry);
+
+#endif // QVMOPS_JUMPTABLE_H
@@ -0,0 +1,522 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "analysis.h"
+#include "jumptable.h"
+#include "globals.h"
+#include "rewrite.h"
+#include "litmerge.h"
+
+// a run of LIT bytes between references and string terminators
+typedef struct litpiece_s {
+	int start;			// LIT offset
+	int end;			// exclusive, including the NUL and any zero padding after it
+	int textlen;		// bytes before the NUL, or -1 if this doesn't look like a string
+	int moved;			// is this a string moved into the merged pool
+	int newstart;		// new LIT offset
+} litpiece_t;
+
+static litpiece_t* pieces;
+static int piececount;
+static int litstart;		// data address of the LIT segment
+static int litend;
+static int dataend;			// end of BSS
+static int shift;			// bytes BSS moves down by
+static uint8_t* addressuse;	// OP_CONSTs whose value is used as an address
+static uint8_t* pointertable;	// OP_CONSTs whose address a pointer is loaded from and used as an address
+static uint8_t* pointerwords;	// data words in a symbol that pointers are loaded from, by address / 4
+static uint8_t* entry;		// instructions a jump can reach
+
+// what is known about a value on the operand stack
+#define ADDRESS_STACK_SIZE 64
+typedef struct addressval_s {
+	int konst;			// OP_CONST the value is (maybe plus an offset), or -1
+	int table;			// OP_CONST whose address (maybe plus an offset) the value was loaded from, or -1
+} addressval_t;
+
+
+// can this byte appear in a string (color codes and other high characters included)
+static int is_text(uint8_t c) {
+	return c >= 0x20 || c == '\t' || c == '\n' || c == '\r';
+}
+
+
+static void address_push(addressval_t* stack, int* depth, int konst, int table) {
+	// drop the bottom of the stack rather than overflow
+	if (*depth == ADDRESS_STACK_SIZE) {
+		memmove(stack, stack + 1, (ADDRESS_STACK_SIZE - 1) * sizeof(addressval_t));
+		(*depth)--;
+	}
+	stack[*depth].konst = konst;
+	stack[*depth].table = table;
+	(*depth)++;
+}
+
+
+static addressval_t address_pop(addressval_t* stack, int* depth) {
+	addressval_t unknown = { -1, -1 };
+	if (!*depth)
+		return unknown;
+	return stack[--(*depth)];
+}
+
+
+// note a value used as an address
+// a loaded value passed as an argument proves nothing, since integers are loaded and passed the same way
+static void address_use(addressval_t v, int arg) {
+	if (v.konst >= 0)
+		addressuse[v.konst] = 1;
+	if (v.table >= 0 && !arg)
+		pointertable[v.table] = 1;
+}
+
+
+// mark each OP_CONST holding a LIT or BSS address (maybe plus an offset) that is loaded from, stored to,
+// copied or passed as an argument, and each OP_CONST whose address holds such a pointer
+static int find_address_uses(void) {
+	addressval_t stack[ADDRESS_STACK_SIZE];
+	int depth = 0;
+
+	addressuse = (uint8_t*)calloc(instructioncount + 1, 1);
+	pointertable = (uint8_t*)calloc(instructioncount + 1, 1);
+	pointerwords = (uint8_t*)calloc(litend / 4 + 1, 1);
+	entry = (uint8_t*)calloc(instructioncount + 1, 1);
+	if (!addressuse || !pointertable || !pointerwords || !entry) {
+		fprintf(stderr, "Unable to allocate LIT memory block: %d\n", instructioncount);
+		return 0;
+	}
+
+	// values reaching a jump target may come from elsewhere
+	for (int index = 0; index < instructioncount; index++) {
+		int target = branch_target(index);
+		if (target >= 0)
+			entry[target] = 1;
+	}
+	for (int t = 0; t < jumptablecount; t++) {
+		for (int i = 0; i < jumptables[t].count; i++)
+			entry[jumptable_target(&jumptables[t], i)] = 1;
+	}
+
+	for (int index = 0; index < instructioncount; index++) {
+		instruction_t* instr = &instructions[index];
+		addressval_t a, b;
+		int pops, pushes;
+
+		if (entry[index] || instr->opcode == OP_ENTER)
+			depth = 0;
+
+		switch (instr->opcode) {
+		case OP_CONST:
+			if (!is_code_ref(index) && instr->param >= 0 && instr->param < dataend)
+				address_push(stack, &depth, index, -1);
+			else
+				address_push(stack, &depth, -1, -1);
+			break;
+		case OP_ADD:
+		case OP_SUB:
+			// an address plus or minus an offset or index
+			b = address_pop(stack, &depth);
+			a = address_pop(stack, &depth);
+			if (a.konst >= 0 || a.table >= 0 || instr->opcode == OP_SUB)
+				address_push(stack, &depth, a.konst, a.table);
+			else
+				address_push(stack, &depth, b.konst, b.table);
+			break;
+		case OP_LOAD1:
+		case OP_LOAD2:
+			address_use(address_pop(stack, &depth), 0);
+			address_push(stack, &depth, -1, -1);
+			break;
+		case OP_LOAD4:
+			a = address_pop(stack, &depth);
+			address_use(a, 0);
+			address_push(stack, &depth, -1, a.konst);
+			break;
+		case OP_STORE1:
+		case OP_STORE2:
+		case OP_STORE4:
+			address_pop(stack, &depth);
+			address_use(address_pop(stack, &depth), 0);
+			break;
+		case OP_BLOCK_COPY:
+			address_use(address_pop(stack, &depth), 0);
+			address_use(address_pop(stack, &depth), 0);
+			break;
+		case OP_ARG:
+			address_use(address_pop(stack, &depth), 1);
+			break;
+		default:
+			opcodestack(instr->opcode, &pops, &pushes);
+			while (pops--)
+				address_pop(stack, &depth);
+			while (pushes--)
+				address_push(stack, &depth, -1, -1);
+		}
+
+		if (instr->opcode == OP_JUMP || instr->opcode == OP_LEAVE)
+			depth = 0;
+	}
+
+	// every word of the symbol a pointer was loaded from (or just the word, without a map) may hold pointers
+	for (int index = 0; index < instructioncount; index++) {
+		int address = instructions[index].param;
+		globalrefs_t* global;
+		if (!pointertable[index] || address >= litend)
+			continue;
+		if ((global = find_global(address))) {
+			for (int word = global->address & ~3; word < global->address + global->size && word + 4 <= litend; word += 4)
+				pointerwords[word / 4] = 1;
+		}
+		else if (!(address & 3) && address + 4 <= litend)
+			pointerwords[address / 4] = 1;
+	}
+
+	return 1;
+}
+
+
+// is a map symbol at exactly this data address
+static int is_symbol_start(int address) {
+	globalrefs_t* global = find_global(address);
+	return global && global->address == address;
+}
+
+
+// does this OP_CONST hold a LIT or BSS address
+// 1 if it (maybe plus an offset) is used as one, -1 if it could be a plain integer
+static int const_pointer(int index) {
+	instruction_t* instr = &instructions[index];
+	if (instr->opcode != OP_CONST || is_code_ref(index) || instr->param < litstart || instr->param >= dataend)
+		return 0;
+	return addressuse[index] ? 1 : -1;
+}
+
+
+// does the data word at this (4-byte aligned) data address hold a LIT or BSS address
+// 1 if it is exactly a map symbol and in a symbol that code loads pointers from, -1 if it could be a plain integer
+// words in LIT must also contain a byte that can't be part of a string, so string bytes aren't mistaken for pointers
+static int data_pointer(int address) {
+	int value;
+	int text = 1;
+
+	if (address + 4 > litend)
+		return 0;
+	memcpy(&value, data + address, sizeof(int));
+	if (value < litstart || value >= dataend || is_data_code_ref(address))
+		return 0;
+	for (int i = 0; address >= litstart && i < 4; i++) {
+		if (data[address + i] && !is_text(data[address + i]))
+			text = 0;
+	}
+	if (address >= litstart && text)
+		return 0;
+	return pointerwords[address / 4] && is_symbol_start(value) ? 1 : -1;
+}
+
+
+// old data address -> new data address
+static int remap_address(int address) {
+	if (address < litstart)
+		return address;
+	if (address < litend)
+		return litstart + litremap[address - litstart];
+	return address - shift;
+}
+
+
+// should a LIT or BSS address be re-pointed
+static int is_pointer(int ref) {
+	return ref > 0 || (ref < 0 && ambiguousrefs == AMBIGUOUS_POINTER);
+}
+
+
+// list ambiguous values that merging would change, returns how many
+static int report_ambiguous_addresses(void) {
+	const char* treatment = ambiguousrefs == AMBIGUOUS_INT ? "left as an integer"
+		: ambiguousrefs == AMBIGUOUS_POINTER ? "re-pointed" : "may be a LIT or BSS address";
+	int count = 0;
+
+	for (int index = 0; index < instructioncount; index++) {
+		int value = instructions[index].param;
+		if (const_pointer(index) >= 0 || remap_address(value) == value)
+			continue;
+		fprintf(stderr, "Instruction %d: OP_CONST %d %s\n", index, value, treatment);
+		count++;
+	}
+	for (int address = 0; address + 4 <= litend; address += 4) {
+		int value;
+		if (data_pointer(address) >= 0)
+			continue;
+		memcpy(&value, data + address, sizeof(int));
+		if (remap_address(value) == value)
+			continue;
+		fprintf(stderr, "Data at 0x%X: %d %s\n", address, value, treatment);
+		count++;
+	}
+
+	return count;
+}
+
+
+// smallest power of two at least size
+static int power_of_two(int size) {
+	int p = 1;
+	while (p < size)
+		p <<= 1;
+	return p;
+}
+
+
+// split LIT at every referenced address and after every string terminator
+static void find_pieces(const uint8_t* referenced) {
+	const uint8_t* lit = data + litstart;
+	int size = litend - litstart;
+	int offset = 0;
+
+	piececount = 0;
+	while (offset < size) {
+		litpiece_t* piece = &pieces[piececount++];
+		int text = 1;
+
+		piece->start = offset;
+		piece->textlen = -1;
+		piece->moved = 0;
+		do {
+			if (!lit[offset]) {
+				piece->textlen = text ? offset - piece->start : -1;
+				// padding stays with the string
+				for (offset++; offset < size && !lit[offset] && !referenced[offset]; offset++)
+					;
+				break;
+			}
+			text = text && is_text(lit[offset]);
+			offset++;
+		} while (offset < size && !referenced[offset]);
+		piece->end = offset;
+	}
+}
+
+
+// compare strings by their last characters first, so each string sorts just before any string it is the tail of
+static int compare_tail(const void* a, const void* b) {
+	const litpiece_t* pa = &pieces[*(const int*)a];
+	const litpiece_t* pb = &pieces[*(const int*)b];
+	const uint8_t* sa = data + litstart + pa->start;
+	const uint8_t* sb = data + litstart + pb->start;
+	int la = pa->textlen;
+	int lb = pb->textlen;
+
+	while (la && lb) {
+		la--;
+		lb--;
+		if (sa[la] != sb[lb])
+			return sa[la] - sb[lb];
+	}
+	if (la != lb)
+		return la - lb;
+	// keep identical strings in LIT order
+	return pa->start - pb->start;
+}
+
+
+// is string a the tail of string b (a sorts before b)
+static int is_tail(const litpiece_t* a, const litpiece_t* b) {
+	return a->textlen <= b->textlen
+		&& !memcmp(data + litstart + a->start, data + litstart + b->start + b->textlen - a->textlen, a->textlen);
+}
+
+
+// write a copy of the loaded qvm (and map) with duplicate LIT strings merged
+int merge_lit(const char* qvmfile, const char* mapfile) {
+	int litsize = datasize[SEGMENT_LIT];
+	int newsize = 0;
+	int oldimage, newimage;
+	int stringcount = 0, movecount = 0, duplicates = 0, tails = 0;
+	int ambiguous;
+	uint8_t* referenced = NULL;
+	int* order = NULL;
+	uint8_t* newlit = NULL;
+	int ok = 0;
+
+	puts("Processing LIT strings...");
+
+	litstart = datasize[SEGMENT_DATA];
+	litend = litstart + litsize;
+	dataend = litend + datasize[SEGMENT_BSS];
+	shift = 0;
+
+	if (!rewrite_begin())
+		return 0;
+
+	// the code doesn't move, only data addresses in it
+	rewrite_copy(0, instructioncount);
+	if (!rewrite_finish())
+		goto done;
+
+	referenced = (uint8_t*)calloc(litsize + 1, 1);
+	pieces = (litpiece_t*)malloc((litsize + 1) * sizeof(litpiece_t));
+	order = (int*)malloc((litsize + 1) * sizeof(int));
+	litremap = (int*)malloc((litsize + 1) * sizeof(int));
+	newlit = (uint8_t*)calloc(litsize + 1, 1);
+	if (!referenced || !pieces || !order || !litremap || !newlit) {
+		fprintf(stderr, "Unable to allocate LIT memory block: %d\n", litsize);
+		goto done;
+	}
+	find_global_refs();
+	if (!find_address_uses())
+		goto done;
+
+	// every address that code or data refers to (or may refer to, unless told they're integers) starts a piece
+	for (int index = 0; index < instructioncount; index++) {
+		int ref = const_pointer(index);
+		if ((ref > 0 || (ref < 0 && ambiguousrefs != AMBIGUOUS_INT)) && instructions[index].param < litend)
+			referenced[instructions[index].param - litstart] = 1;
+	}
+	for (int address = 0; address + 4 <= litend; address += 4) {
+		int value;
+		int ref = data_pointer(address);
+		if (!ref || (ref < 0 && ambiguousrefs == AMBIGUOUS_INT))
+			continue;
+		memcpy(&value, data + address, sizeof(int));
+		if (value < litend)
+			referenced[value - litstart] = 1;
+	}
+	find_pieces(referenced);
+
+	// a string can only move if nothing can be read into or out of it from a neighbour: it and the
+	// piece after it must be referenced directly, and the piece before it must be terminated
+	for (int i = 0; i < piececount; i++) {
+		litpiece_t* piece = &pieces[i];
+		if (piece->textlen < 0)
+			continue;
+		stringcount++;
+		if (!referenced[piece->start])
+			continue;
+		if (i + 1 < piececount && !referenced[pieces[i + 1].start])
+			continue;
+		if (i > 0 && data[litstart + piece->start - 1])
+			continue;
+		piece->moved = 1;
+		order[movecount++] = i;
+	}
+
+	// everything else keeps its layout and alignment, in order
+	for (int i = 0; i < piececount; i++) {
+		litpiece_t* piece = &pieces[i];
+		if (piece->moved)
+			continue;
+		if (!i || pieces[i - 1].moved) {
+			while ((newsize & 3) != (piece->start & 3))
+				newsize++;
+		}
+		piece->newstart = newsize;
+		newsize += piece->end - piece->start;
+	}
+
+	// then the moved strings, with each one stored once and any string that ends another sharing its tail
+	qsort(order, movecount, sizeof(int), compare_tail);
+	for (int k = movecount - 1; k >= 0; k--) {
+		litpiece_t* piece = &pieces[order[k]];
+		if (k + 1 < movecount && is_tail(piece, &pieces[order[k + 1]])) {
+			litpiece_t* into = &pieces[order[k + 1]];
+			piece->newstart = into->newstart + into->textlen - piece->textlen;
+			if (piece->textlen == into->textlen)
+				duplicates++;
+			else
+				tails++;
+			continue;
+		}
+		piece->newstart = newsize;
+		newsize += piece->textlen + 1;
+	}
+
+	// BSS must stay aligned
+	while ((litsize - newsize) & 3)
+		newsize++;
+
+	if (newsize >= litsize) {
+		// alignment cost more than merging saved
+		for (int i = 0; i < piececount; i++)
+			pieces[i].newstart = pieces[i].start;
+		newsize = litsize;
+		duplicates = tails = 0;
+	}
+	shift = litsize - newsize;
+
+	for (int i = 0; i < piececount; i++) {
+		litpiece_t* piece = &pieces[i];
+		int length = piece->moved && shift ? piece->textlen + 1 : piece->end - piece->start;
+		for (int offset = piece->start; offset < piece->end; offset++)
+			litremap[offset] = piece->newstart + (offset - piece->start < length ? offset - piece->start : length - 1);
+		memcpy(newlit + piece->newstart, data + litstart + piece->start, length);
+	}
+	memcpy(newdata + litstart, newlit, newsize);
+	newdatasize[SEGMENT_LIT] = newsize;
+
+	ambiguous = report_ambiguous_addresses();
+	if (ambiguous && ambiguousrefs == AMBIGUOUS_REFUSE) {
+		fprintf(stderr, "%d value(s) may or may not be LIT or BSS addresses, not writing (use --ambiguous int or --ambiguous pointer)\n", ambiguous);
+		goto done;
+	}
+
+	// re-point every LIT and BSS address in the code and data
+	for (int i = 0; i < newcount; i++) {
+		if (neworigin[i] >= 0 && is_pointer(const_pointer(neworigin[i])))
+			newcode[i].param = remap_address(newcode[i].param);
+	}
+	for (int address = 0; address + 4 <= litend; address += 4) {
+		int value;
+		int newaddress = remap_address(address);
+		if (!is_pointer(data_pointer(address)))
+			continue;
+		// a pointer can't straddle a moved string
+		if (address >= litstart && remap_address(address + 3) != newaddress + 3)
+			continue;
+		memcpy(&value, data + address, sizeof(int));
+		value = remap_address(value);
+		memcpy(newdata + newaddress, &value, sizeof(int));
+	}
+
+	ok = write_qvm(qvmfile) && write_map(mapfile);
+
+	// the engine rounds each instance's data image up to a power of two
+	oldimage = dataend;
+	newimage = dataend - shift;
+	printf("Merged %d duplicate and %d tail strings (%d of %d strings could move), LIT segment %d -> %d bytes (%d saved)\n",
+		duplicates, tails, movecount, stringcount, litsize, newsize, shift);
+	printf("Data image per VM instance %d -> %d bytes, %d -> %d allocated\n",
+		oldimage, newimage, power_of_two(oldimage), power_of_two(newimage));
+
+done:
+	free(referenced);
+	free(pieces);
+	free(order);
+	free(newlit);
+	free(addressuse);
+	free(pointertable);
+	free(pointerwords);
+	free(entry);
+	addressuse = NULL;
+	pointertable = NULL;
+	pointerwords = NULL;
+	entry = NULL;
+	pieces = NULL;
+	piececount = 0;
+	rewrite_end();
+	return ok;
+}
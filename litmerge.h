@@ -0,0 +1,22 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_LITMERGE_H
+#define QVMOPS_LITMERGE_H
+
+#include "qvm.h"
+
+// write a copy of the loaded qvm (and map) with duplicate LIT strings merged, and strings that end
+// another string stored as its tail. BSS moves down by the bytes saved
+int merge_lit(const char* qvmfile, const char* mapfile);
+
+#endif // QVMOPS_LITMERGE_H
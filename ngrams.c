@@ -0,0 +1,282 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "qvm.h"
+#include "analysis.h"
+#include "cost.h"
+#include "rewrite.h"
+#include "ngrams.h"
+
+// a counted opcode sequence
+typedef struct ngram_s {
+	uint8_t len;				// number of instructions, 0 for an empty slot
+	uint8_t operands;			// bit n set if params[n] is part of the sequence
+	uint8_t ops[MAX_NGRAM];
+	int params[MAX_NGRAM];		// 0 unless the param is a pattern operand
+	int64_t count;
+} ngram_t;
+
+// open addressing hash table of sequences, shared by all qvms in a run
+static ngram_t* ngrams;
+static int ngramsize;
+static int ngramused;
+
+// total sequences counted by [len][with operands]
+static int64_t ngramtotal[MAX_NGRAM + 1][2];
+static int ngramqvms;
+static int ngramweighted;
+
+
+// is this instruction's param a useful part of a superinstruction pattern (small constants, frame offsets)
+// code addresses and frame sizes vary too much to be worth matching
+static int operand_pattern(int index) {
+	switch (instructions[index].opcode) {
+	case OP_LOCAL:
+	case OP_ARG:
+	case OP_BLOCK_COPY:
+		return 1;
+	case OP_CONST:
+		return !is_code_ref(index);
+	default:
+		return 0;
+	}
+}
+
+
+// does control never fall through from this instruction to the next
+static int ends_block(vmop_t op) {
+	return is_branch(op) || op == OP_JUMP || op == OP_LEAVE;
+}
+
+
+static uint32_t hash_ngram(const ngram_t* ngram) {
+	uint32_t hash = 2166136261u;
+	const uint8_t* p = (const uint8_t*)ngram->params;
+
+	hash = (hash ^ ngram->len) * 16777619u;
+	hash = (hash ^ ngram->operands) * 16777619u;
+	for (int i = 0; i < ngram->len; i++)
+		hash = (hash ^ ngram->ops[i]) * 16777619u;
+	if (ngram->operands) {
+		for (size_t i = 0; i < ngram->len * sizeof(int); i++)
+			hash = (hash ^ p[i]) * 16777619u;
+	}
+	return hash;
+}
+
+
+static int same_ngram(const ngram_t* a, const ngram_t* b) {
+	return a->len == b->len && a->operands == b->operands
+		&& !memcmp(a->ops, b->ops, a->len)
+		&& !memcmp(a->params, b->params, a->len * sizeof(int));
+}
+
+
+// add to the count of a sequence, growing the table as needed
+static int add_ngram(const ngram_t* key, int64_t weight) {
+	uint32_t mask;
+	uint32_t slot;
+
+	// keep the table at most half full
+	if ((ngramused + 1) * 2 > ngramsize) {
+		ngram_t* old = ngrams;
+		int oldsize = ngramsize;
+		int newsize = ngramsize ? ngramsize * 2 : 4096;
+		ngram_t* grown = (ngram_t*)calloc(newsize, sizeof(ngram_t));
+		if (!grown) {
+			fprintf(stderr, "Unable to allocate n-gram table: %d entries\n", newsize);
+			return 0;
+		}
+		ngrams = grown;
+		ngramsize = newsize;
+		mask = newsize - 1;
+		for (int i = 0; i < oldsize; i++) {
+			if (!old[i].len)
+				continue;
+			slot = hash_ngram(&old[i]) & mask;
+			while (ngrams[slot].len)
+				slot = (slot + 1) & mask;
+			ngrams[slot] = old[i];
+		}
+		free(old);
+	}
+
+	mask = ngramsize - 1;
+	slot = hash_ngram(key) & mask;
+	while (ngrams[slot].len) {
+		if (same_ngram(&ngrams[slot], key)) {
+			ngrams[slot].count += weight;
+			return 1;
+		}
+		slot = (slot + 1) & mask;
+	}
+	ngrams[slot] = *key;
+	ngrams[slot].count = weight;
+	ngramused++;
+	return 1;
+}
+
+
+// count opcode sequences of 2 through maxlen instructions in the loaded qvm, between instruction indexes start and end (exclusive)
+// counts accumulate across calls until report_ngrams
+void count_ngrams(int start, int end, int maxlen, int weighted) {
+	uint8_t* entry;
+
+	puts("Processing opcode n-grams...");
+
+	if (maxlen > MAX_NGRAM)
+		maxlen = MAX_NGRAM;
+	ngramqvms++;
+	ngramweighted = weighted;
+	if (weighted)
+		find_loops();
+
+	// a sequence can't continue into an instruction that is jumped to, since it would then have to be entered midway
+	entry = (uint8_t*)calloc(instructioncount ? instructioncount : 1, 1);
+	if (!entry) {
+		fprintf(stderr, "Unable to allocate n-gram memory\n");
+		return;
+	}
+	for (int f = 0; f < functioncount; f++)
+		entry[functions[f].start] = 1;
+	for (int index = 0; index < instructioncount; index++) {
+		int target = branch_target(index);
+		if (target >= 0 && target < instructioncount)
+			entry[target] = 1;
+	}
+	for (int address = 0; address + 4 <= datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT]; address += 4) {
+		int value;
+		if (!is_data_code_ref(address))
+			continue;
+		memcpy(&value, data + address, sizeof(int));
+		entry[value] = 1;
+	}
+
+	for (int index = start; index < end; index++) {
+		ngram_t key;
+		int64_t weight = 1;
+
+		if (weighted) {
+			int depth = loopdepth[index];
+			if (depth > MAX_LOOP_DEPTH)
+				depth = MAX_LOOP_DEPTH;
+			while (depth--)
+				weight *= LOOP_WEIGHT;
+		}
+
+		memset(&key, 0, sizeof(key));
+		key.ops[0] = (uint8_t)instructions[index].opcode;
+		for (int len = 2; len <= maxlen; len++) {
+			int next = index + len - 1;
+			if (next >= end || entry[next] || ends_block(instructions[next - 1].opcode))
+				break;
+			key.ops[len - 1] = (uint8_t)instructions[next].opcode;
+			key.len = (uint8_t)len;
+
+			key.operands = 0;
+			memset(key.params, 0, sizeof(key.params));
+			if (!add_ngram(&key, weight))
+				break;
+			ngramtotal[len][0] += weight;
+
+			// the same sequence with its operands, if any of them matter
+			for (int i = 0; i < len; i++) {
+				if (operand_pattern(index + i)) {
+					key.operands |= 1 << i;
+					key.params[i] = instructions[index + i].param;
+				}
+			}
+			if (!key.operands)
+				continue;
+			if (!add_ngram(&key, weight))
+				break;
+			ngramtotal[len][1] += weight;
+		}
+	}
+
+	free(entry);
+}
+
+
+// sort by count, highest first, then by sequence
+static int compare_ngram(const void* a, const void* b) {
+	const ngram_t* na = *(const ngram_t**)a;
+	const ngram_t* nb = *(const ngram_t**)b;
+	int c;
+	if (na->count != nb->count)
+		return na->count < nb->count ? 1 : -1;
+	c = memcmp(na->ops, nb->ops, na->len);
+	if (c)
+		return c;
+	if (na->operands != nb->operands)
+		return na->operands - nb->operands;
+	return memcmp(na->params, nb->params, na->len * sizeof(int));
+}
+
+
+// output the most common sequences of one length, with or without operands
+static void report_ngram_length(FILE* h, ngram_t** sorted, int len, int operands) {
+	int count = 0;
+
+	for (int i = 0; i < ngramsize; i++) {
+		if (ngrams[i].len == len && !ngrams[i].operands == !operands)
+			sorted[count++] = &ngrams[i];
+	}
+	if (!count)
+		return;
+	qsort(sorted, count, sizeof(ngram_t*), compare_ngram);
+
+	fprintf(h, "\n%d-GRAMS%s (%lld total, %d distinct)\n", len, operands ? " WITH OPERANDS" : "", (long long)ngramtotal[len][operands], count);
+	fprintf(h, "%14s %7s  %s\n", "COUNT", "%", "SEQUENCE");
+	for (int i = 0; i < count && i < NGRAM_TOP; i++) {
+		ngram_t* ngram = sorted[i];
+		fprintf(h, "%14lld %6.2f%%  ", (long long)ngram->count, 100.0 * ngram->count / ngramtotal[len][operands]);
+		for (int k = 0; k < len; k++) {
+			fprintf(h, "%s%s", k ? "; " : "", opcodename((vmop_t)ngram->ops[k]));
+			if (ngram->operands & (1 << k))
+				fprintf(h, " %d", ngram->params[k]);
+		}
+		fputc('\n', h);
+	}
+}
+
+
+// output the most common opcode sequences and operand patterns counted so far, and free them
+void report_ngrams(FILE* h) {
+	ngram_t** sorted;
+
+	if (!ngramqvms)
+		return;
+
+	sorted = (ngram_t**)malloc((ngramused ? ngramused : 1) * sizeof(ngram_t*));
+	if (!sorted) {
+		fprintf(stderr, "Unable to allocate n-gram report memory\n");
+		return;
+	}
+
+	fputs("\nOPCODE N-GRAMS\n==============\n", h);
+	fprintf(h, "Sequences from %d QVM(s), not crossing jump targets or control transfers%s\n", ngramqvms,
+		ngramweighted ? ", weighted by loop depth" : "");
+	for (int len = 2; len <= MAX_NGRAM; len++)
+		report_ngram_length(h, sorted, len, 0);
+	for (int len = 2; len <= MAX_NGRAM; len++)
+		report_ngram_length(h, sorted, len, 1);
+
+	free(sorted);
+	free(ngrams);
+	ngrams = NULL;
+	ngramsize = ngramused = ngramqvms = 0;
+	memset(ngramtotal, 0, sizeof(ngramtotal));
+}
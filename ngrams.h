@@ -0,0 +1,30 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_NGRAMS_H
+#define QVMOPS_NGRAMS_H
+
+#include <stdio.h>
+
+// longest opcode sequence counted
+#define MAX_NGRAM	4
+// number of sequences of each length shown in report
+#define NGRAM_TOP	25
+
+// count opcode sequences of 2 through maxlen instructions in the loaded qvm, between instruction indexes start and end (exclusive)
+// counts accumulate across calls until report_ngrams
+void count_ngrams(int start, int end, int maxlen, int weighted);
+
+// output the most common opcode sequences and operand patterns counted so far, and free them
+void report_ngrams(FILE* h);
+
+#endif // QVMOPS_NGRAMS_H
@@ -0,0 +1,248 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "qvm.h"
+#include "analysis.h"
+#include "rewrite.h"
+#include "jumptable.h"
+#include "opstack.h"
+
+int16_t opdepth[MAX_INSTRUCTIONS];
+uint8_t optype[MAX_INSTRUCTIONS];
+int opmismatches;
+
+// deepest stack whose producers are tracked, deeper values are just counted
+#define OPSTACK_TRACK	64
+
+
+char optype_char(int type) {
+	static const char chars[] = "-?ifx";
+	if (type < 0 || type > OPTYPE_MIXED)
+		return '?';
+	return chars[type];
+}
+
+
+// type an opcode gives the value it pushes, from the opcode alone
+static int result_type(vmop_t op) {
+	int pops, pushes;
+
+	switch (op) {
+	case OP_CONST:
+	case OP_LOAD4:
+	case OP_CALL:
+		return OPTYPE_UNKNOWN;
+	case OP_NEGF:
+	case OP_ADDF:
+	case OP_SUBF:
+	case OP_DIVF:
+	case OP_MULF:
+	case OP_CVIF:
+		return OPTYPE_FLOAT;
+	default:
+		opcodestack(op, &pops, &pushes);
+		return pushes ? OPTYPE_INT : OPTYPE_NONE;
+	}
+}
+
+
+// type an opcode needs its operand to be (operand 0 is the top of the stack)
+static int operand_type(vmop_t op, int operand) {
+	switch (op) {
+	case OP_POP:
+	case OP_LEAVE:
+	case OP_ARG:
+		return OPTYPE_UNKNOWN;
+	case OP_STORE4:
+		// the value can be anything, the address is an int
+		return operand == 0 ? OPTYPE_UNKNOWN : OPTYPE_INT;
+	case OP_EQF:
+	case OP_NEF:
+	case OP_LTF:
+	case OP_LEF:
+	case OP_GTF:
+	case OP_GEF:
+	case OP_NEGF:
+	case OP_ADDF:
+	case OP_SUBF:
+	case OP_DIVF:
+	case OP_MULF:
+	case OP_CVFI:
+		return OPTYPE_FLOAT;
+	default:
+		return OPTYPE_INT;
+	}
+}
+
+
+static void add_type(int index, int type) {
+	if (type == OPTYPE_UNKNOWN || optype[index] == type)
+		return;
+	if (optype[index] == OPTYPE_UNKNOWN)
+		optype[index] = (uint8_t)type;
+	else
+		optype[index] = OPTYPE_MIXED;
+}
+
+
+// set the depth at an instruction reached from another, queueing it the first time
+static void reach(int from, int index, int depth, int* worklist, int* count) {
+	if (index < 0 || index >= instructioncount)
+		return;
+	if (opdepth[index] == OPDEPTH_UNKNOWN) {
+		opdepth[index] = (int16_t)depth;
+		worklist[(*count)++] = index;
+	}
+	else if (opdepth[index] != depth) {
+		fprintf(stderr, "Operand stack depth mismatch at %d: %d from %d, %d before\n", index, depth, from, opdepth[index]);
+		opmismatches++;
+	}
+}
+
+
+// find the operand stack depth at each instruction by flowing through branches, and the int/float type of each value
+void find_opstack(void) {
+	int* worklist;
+	int* producer;
+	uint8_t* target;
+	int count = 0;
+
+	opmismatches = 0;
+	for (int index = 0; index < instructioncount; index++)
+		opdepth[index] = OPDEPTH_UNKNOWN;
+
+	worklist = (int*)malloc((instructioncount + 1) * sizeof(int));
+	producer = (int*)malloc(OPSTACK_TRACK * sizeof(int));
+	target = (uint8_t*)calloc(instructioncount + 1, 1);
+	if (!worklist || !producer || !target) {
+		fprintf(stderr, "Unable to allocate operand stack memory\n");
+		free(worklist);
+		free(producer);
+		free(target);
+		return;
+	}
+
+	// functions start with an empty stack, and so do switch cases (unless their table was found, computed jumps can't be followed)
+	for (int f = 0; f < functioncount; f++)
+		reach(-1, functions[f].start, 0, worklist, &count);
+	for (int address = 0; address + 4 <= datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT]; address += 4) {
+		int value;
+		if (!is_data_code_ref(address))
+			continue;
+		memcpy(&value, data + address, sizeof(int));
+		reach(-1, value, 0, worklist, &count);
+		target[value] = 1;
+	}
+	for (int index = 0; index < instructioncount; index++) {
+		int t = branch_target(index);
+		if (t >= 0)
+			target[t] = 1;
+	}
+
+	// each instruction is queued once, when first reached
+	while (count) {
+		int index = worklist[--count];
+		vmop_t op = instructions[index].opcode;
+		int pops, pushes;
+		int depth;
+
+		opcodestack(op, &pops, &pushes);
+		depth = opdepth[index] - pops + pushes;
+		if (depth < 0) {
+			fprintf(stderr, "Operand stack underflow at %d\n", index);
+			opmismatches++;
+			depth = 0;
+		}
+
+		if (op == OP_ENTER)
+			depth = 0;
+		reach(index, branch_target(index), depth, worklist, &count);
+		if (op == OP_JUMP) {
+			jumptable_t* table = find_jumptable(index);
+			for (int i = 0; table && i < table->count; i++)
+				reach(index, jumptable_target(table, i), depth, worklist, &count);
+		}
+		if (op != OP_JUMP && op != OP_LEAVE && index + 1 < instructioncount && instructions[index + 1].opcode != OP_ENTER)
+			reach(index, index + 1, depth, worklist, &count);
+	}
+
+	// match each value to the instructions that use it, within straight-line code
+	// values still on the stack at a branch target come from more than one place and are left alone
+	for (int index = 0; index < instructioncount; index++)
+		optype[index] = (uint8_t)result_type(instructions[index].opcode);
+	for (int f = 0; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		int depth = 0;
+
+		for (int index = func->start; index < func->end; index++) {
+			vmop_t op = instructions[index].opcode;
+			int pops, pushes;
+
+			if (opdepth[index] == OPDEPTH_UNKNOWN)
+				continue;
+			if (index == func->start || opdepth[index] != depth || target[index]) {
+				depth = opdepth[index];
+				for (int i = 0; i < depth && i < OPSTACK_TRACK; i++)
+					producer[i] = -1;
+			}
+
+			opcodestack(op, &pops, &pushes);
+			for (int i = 0; i < pops && depth > 0; i++) {
+				depth--;
+				if (depth < OPSTACK_TRACK && producer[depth] >= 0)
+					add_type(producer[depth], operand_type(op, i));
+			}
+			for (int i = 0; i < pushes; i++) {
+				if (depth < OPSTACK_TRACK)
+					producer[depth] = index;
+				depth++;
+			}
+			if (op == OP_ENTER)
+				depth = 0;
+		}
+	}
+
+	free(worklist);
+	free(producer);
+	free(target);
+}
+
+
+// write opdepth/optype as text, one instruction per line
+int write_opstack(const char* file) {
+	FILE* h;
+	int ok;
+
+	printf("Writing %s...\n", file);
+
+	h = fopen(file, "w");
+	if (!h) {
+		fprintf(stderr, "Unable to open %s for writing\n", file);
+		return 0;
+	}
+
+	// depth is before the instruction, -1 if unreachable. type is of the value pushed
+	fprintf(h, "# index depth type\n");
+	for (int index = 0; index < instructioncount; index++)
+		fprintf(h, "%d %d %c\n", index, opdepth[index], optype_char(optype[index]));
+
+	ok = !ferror(h);
+	fclose(h);
+
+	if (!ok)
+		fprintf(stderr, "Error writing %s\n", file);
+	return ok;
+}
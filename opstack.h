@@ -0,0 +1,48 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_OPSTACK_H
+#define QVMOPS_OPSTACK_H
+
+#include <stdint.h>
+#include "qvm.h"
+
+// operand stack depth before an instruction that no path reaches
+#define OPDEPTH_UNKNOWN	-1
+
+// type of the value an instruction pushes
+enum {
+	OPTYPE_NONE,		// pushes nothing
+	OPTYPE_UNKNOWN,		// a 4-byte value never used as either (OP_CONST, OP_LOAD4, OP_CALL, ...)
+	OPTYPE_INT,
+	OPTYPE_FLOAT,
+	OPTYPE_MIXED,		// used as both
+};
+
+// operand stack depth before each instruction (filled by find_opstack)
+extern int16_t opdepth[MAX_INSTRUCTIONS];
+// type of the value pushed by each instruction (filled by find_opstack)
+extern uint8_t optype[MAX_INSTRUCTIONS];
+// number of join points reached with different stack depths
+extern int opmismatches;
+
+// single character for an OPTYPE_ value
+char optype_char(int type);
+
+// find the operand stack depth at each instruction by flowing through branches, and the int/float type of each value
+// from the opcodes that produce and consume it. depth mismatches at join points are printed
+void find_opstack(void);
+
+// write opdepth/optype as text, one instruction per line
+int write_opstack(const char* file);
+
+#endif // QVMOPS_OPSTACK_H
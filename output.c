@@ -0,0 +1,133 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include "output.h"
+#include "stats.h"
+
+
+// open an output file for writing
+output_t* out_open(const char* file, int compress) {
+	output_t* out;
+
+	out = (output_t*)calloc(1, sizeof(output_t));
+	if (!out) {
+		fprintf(stderr, "Unable to allocate output handle\n");
+		return NULL;
+	}
+
+	out->h = fopen(file, compress ? "wb" : "w");
+	if (!out->h || ferror(out->h)) {
+		fprintf(stderr, "File not found: %s\n", file);
+		goto fail;
+	}
+
+	if (compress) {
+		out->z = deflate_open(out->h, compress == COMPRESS_GZIP_THREAD);
+		if (!out->z) {
+			fprintf(stderr, "Unable to start compression for %s\n", file);
+			goto fail;
+		}
+	}
+
+	return out;
+fail:
+	if (out->h)
+		fclose(out->h);
+	free(out);
+	return NULL;
+}
+
+
+// flush and close an output file, returns 0 on write error
+int out_close(output_t* out) {
+	int ok = 1;
+
+	if (!out)
+		return 0;
+	if (out->z && !deflate_close(out->z))
+		ok = 0;
+	if (out->h) {
+		if (ferror(out->h))
+			ok = 0;
+		fclose(out->h);
+	}
+	free(out);
+	return ok;
+}
+
+
+// raw write to output file
+void out_write(output_t* out, const void* buf, size_t len) {
+	if (out->z)
+		deflate_write(out->z, (const uint8_t*)buf, len);
+	else
+		fwrite(buf, 1, len, out->h);
+
+	out->pos += len;
+	stats.bytes_written += len;
+	stats.write_calls++;
+}
+
+
+// formatted write to output file
+int out_printf(output_t* out, const char* fmt, ...) {
+	char buf[1024];
+	char* p = buf;
+	va_list args;
+	int n;
+
+	va_start(args, fmt);
+	n = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+
+	// rare long lines get a temporary buffer
+	if (n >= (int)sizeof(buf)) {
+		p = (char*)malloc(n + 1);
+		if (!p)
+			return -1;
+		va_start(args, fmt);
+		vsnprintf(p, n + 1, fmt, args);
+		va_end(args);
+	}
+
+	if (n > 0)
+		out_write(out, p, n);
+
+	if (p != buf)
+		free(p);
+
+	return n;
+}
+
+
+// unformatted write to output file
+int out_puts(output_t* out, const char* str) {
+	size_t n = strlen(str);
+
+	out_write(out, str, n);
+
+	return (int)n;
+}
+
+
+// flush output file to disk
+// compressed output is not flushed, since ending a deflate block early costs compression
+void out_flush(output_t* out) {
+	if (out->z)
+		return;
+	fflush(out->h);
+	stats.flush_calls++;
+}
@@ -0,0 +1,44 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_OUTPUT_H
+#define QVMOPS_OUTPUT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "deflate.h"
+
+// compression modes for out_open
+enum {
+	COMPRESS_NONE,
+	COMPRESS_GZIP,
+	COMPRESS_GZIP_THREAD,	// compress on a separate thread
+};
+
+// output file handle that keeps track of how much has been written
+typedef struct output_s {
+	FILE* h;
+	deflate_t* z;		// gzip stream, if compressing
+	int64_t pos;		// number of (uncompressed) bytes written so far
+} output_t;
+
+// open/close an output file
+output_t* out_open(const char* file, int compress);
+int out_close(output_t* out);
+
+// write to an output file
+int out_printf(output_t* out, const char* fmt, ...);
+int out_puts(output_t* out, const char* str);
+void out_write(output_t* out, const void* buf, size_t len);
+void out_flush(output_t* out);
+
+#endif // QVMOPS_OUTPUT_H
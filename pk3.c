@@ -0,0 +1,538 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pk3.h"
+#include "util.h"
+
+// zip record signatures
+#define ZIP_LOCAL_SIG	0x04034b50
+#define ZIP_CENTRAL_SIG	0x02014b50
+#define ZIP_END_SIG		0x06054b50
+
+// fixed sizes of zip records (not counting variable-length fields)
+#define ZIP_LOCAL_LEN	30
+#define ZIP_CENTRAL_LEN	46
+#define ZIP_END_LEN		22
+
+// zip compression methods
+#define ZIP_STORED		0
+#define ZIP_DEFLATE		8
+
+
+// read little endian values from a buffer
+static uint32_t read16(const uint8_t* p) {
+	return p[0] | (p[1] << 8);
+}
+static uint32_t read32(const uint8_t* p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+// open a pk3 and read its central directory
+int pk3_open(const char* file, pk3_t* pk3) {
+	uint8_t* buf = NULL;
+	uint8_t* end = NULL;
+	long filesize;
+	long searchsize;
+	uint32_t cdsize, cdoffset;
+	int count;
+	uint8_t* p;
+
+	memset(pk3, 0, sizeof(pk3_t));
+
+	printf("Opening %s...\n", file);
+
+	pk3->h = fopen(file, "rb");
+	if (!pk3->h || feof(pk3->h) || ferror(pk3->h)) {
+		fprintf(stderr, "File not found: %s\n", file);
+		goto fail;
+	}
+
+	// the end of central directory record is at the end of the file, followed by a comment of up to 64KB
+	fseek(pk3->h, 0, SEEK_END);
+	filesize = ftell(pk3->h);
+	pk3->filesize = filesize;
+	searchsize = filesize < ZIP_END_LEN + 0xFFFF ? filesize : ZIP_END_LEN + 0xFFFF;
+	buf = (uint8_t*)malloc(searchsize);
+	if (!buf) {
+		fprintf(stderr, "Unable to allocate pk3 memory block: %ld\n", searchsize);
+		goto fail;
+	}
+	fseek(pk3->h, filesize - searchsize, SEEK_SET);
+	if (fread(buf, 1, searchsize, pk3->h) != (size_t)searchsize) {
+		fprintf(stderr, "Invalid pk3 file: unable to read %s\n", file);
+		goto fail;
+	}
+
+	for (p = buf + searchsize - ZIP_END_LEN; p >= buf; p--) {
+		if (read32(p) == ZIP_END_SIG) {
+			end = p;
+			break;
+		}
+	}
+	if (!end) {
+		fprintf(stderr, "Invalid pk3 file: no central directory\n");
+		goto fail;
+	}
+
+	count = read16(end + 10);
+	cdsize = read32(end + 12);
+	cdoffset = read32(end + 16);
+	free(buf);
+
+	if (cdoffset == 0xFFFFFFFF || (long)cdoffset + (long)cdsize > filesize) {
+		fprintf(stderr, "Invalid pk3 file: invalid central directory (zip64 is not supported)\n");
+		buf = NULL;
+		goto fail;
+	}
+
+	// read whole central directory
+	buf = (uint8_t*)malloc(cdsize ? cdsize : 1);
+	pk3->entries = (pk3entry_t*)calloc(count ? count : 1, sizeof(pk3entry_t));
+	if (!buf || !pk3->entries) {
+		fprintf(stderr, "Unable to allocate pk3 directory: %d entries\n", count);
+		goto fail;
+	}
+	fseek(pk3->h, cdoffset, SEEK_SET);
+	if (fread(buf, 1, cdsize, pk3->h) != cdsize) {
+		fprintf(stderr, "Invalid pk3 file: unable to read central directory\n");
+		goto fail;
+	}
+
+	p = buf;
+	for (int i = 0; i < count; i++) {
+		pk3entry_t* entry = &pk3->entries[pk3->entrycount];
+		int namelen, extralen, commentlen;
+
+		if (p + ZIP_CENTRAL_LEN > buf + cdsize || read32(p) != ZIP_CENTRAL_SIG) {
+			fprintf(stderr, "Invalid pk3 file: corrupt central directory\n");
+			goto fail;
+		}
+		namelen = read16(p + 28);
+		extralen = read16(p + 30);
+		commentlen = read16(p + 32);
+		if (p + ZIP_CENTRAL_LEN + namelen > buf + cdsize) {
+			fprintf(stderr, "Invalid pk3 file: corrupt central directory\n");
+			goto fail;
+		}
+
+		entry->method = read16(p + 10);
+		entry->crc = read32(p + 16);
+		entry->compsize = read32(p + 20);
+		entry->size = read32(p + 24);
+		entry->offset = read32(p + 42);
+		entry->name = (char*)malloc(namelen + 1);
+		if (!entry->name) {
+			fprintf(stderr, "Unable to allocate pk3 directory\n");
+			goto fail;
+		}
+		memcpy(entry->name, p + ZIP_CENTRAL_LEN, namelen);
+		entry->name[namelen] = '\0';
+		pk3->entrycount++;
+
+		p += ZIP_CENTRAL_LEN + namelen + extralen + commentlen;
+	}
+
+	free(buf);
+	return 1;
+
+fail:
+	free(buf);
+	pk3_close(pk3);
+	return 0;
+}
+
+
+void pk3_close(pk3_t* pk3) {
+	if (pk3->h)
+		fclose(pk3->h);
+	for (int i = 0; i < pk3->entrycount; i++)
+		free(pk3->entries[i].name);
+	free(pk3->entries);
+	memset(pk3, 0, sizeof(pk3_t));
+}
+
+
+// find an entry by name (case-insensitive), or NULL
+pk3entry_t* pk3_find(pk3_t* pk3, const char* name) {
+	for (int i = 0; i < pk3->entrycount; i++) {
+		if (striequal(pk3->entries[i].name, name))
+			return &pk3->entries[i];
+	}
+	return NULL;
+}
+
+
+// read and decompress an entry into a newly allocated buffer
+uint8_t* pk3_read(pk3_t* pk3, pk3entry_t* entry, int* size) {
+	uint8_t header[ZIP_LOCAL_LEN];
+	uint8_t* comp = NULL;
+	uint8_t* out = NULL;
+
+	// local header may have a different extra field length than the central directory
+	fseek(pk3->h, entry->offset, SEEK_SET);
+	if (fread(header, 1, ZIP_LOCAL_LEN, pk3->h) != ZIP_LOCAL_LEN || read32(header) != ZIP_LOCAL_SIG) {
+		fprintf(stderr, "Invalid pk3 file: corrupt local header for %s\n", entry->name);
+		return NULL;
+	}
+	fseek(pk3->h, entry->offset + ZIP_LOCAL_LEN + read16(header + 26) + read16(header + 28), SEEK_SET);
+
+	if (entry->method != ZIP_STORED && entry->method != ZIP_DEFLATE) {
+		fprintf(stderr, "Unsupported compression method %d for %s\n", entry->method, entry->name);
+		return NULL;
+	}
+
+	// sizes come from the archive, so don't trust them to allocate or read with
+	if (entry->size > PK3_MAX_ENTRY || entry->compsize > PK3_MAX_ENTRY || (long)entry->compsize > pk3->filesize
+		|| (entry->method == ZIP_STORED && entry->size != entry->compsize)) {
+		fprintf(stderr, "Invalid pk3 file: bad size for %s: %u (%u compressed)\n", entry->name, entry->size, entry->compsize);
+		return NULL;
+	}
+
+	// one extra byte so empty entries still get a valid buffer
+	out = (uint8_t*)malloc(entry->size + 1);
+	if (!out) {
+		fprintf(stderr, "Unable to allocate memory for %s: %u\n", entry->name, entry->size);
+		return NULL;
+	}
+
+	if (entry->method == ZIP_STORED) {
+		if (fread(out, 1, entry->size, pk3->h) != entry->size) {
+			fprintf(stderr, "Invalid pk3 file: unable to read %s\n", entry->name);
+			goto fail;
+		}
+	}
+	else {
+		comp = (uint8_t*)malloc(entry->compsize + 1);
+		if (!comp) {
+			fprintf(stderr, "Unable to allocate memory for %s: %u\n", entry->name, entry->compsize);
+			goto fail;
+		}
+		if (fread(comp, 1, entry->compsize, pk3->h) != entry->compsize) {
+			fprintf(stderr, "Invalid pk3 file: unable to read %s\n", entry->name);
+			goto fail;
+		}
+		if (!inflate_buf(comp, entry->compsize, out, entry->size)) {
+			fprintf(stderr, "Invalid pk3 file: unable to decompress %s\n", entry->name);
+			goto fail;
+		}
+		free(comp);
+		comp = NULL;
+	}
+
+	if (crc32_buf(0, out, entry->size) != entry->crc) {
+		fprintf(stderr, "Invalid pk3 file: CRC mismatch for %s\n", entry->name);
+		goto fail;
+	}
+
+	*size = (int)entry->size;
+	return out;
+
+fail:
+	free(comp);
+	free(out);
+	return NULL;
+}
+
+
+// inflate state
+typedef struct inflate_s {
+	const uint8_t* in;
+	size_t inlen;
+	size_t inpos;
+	uint32_t bitbuf;
+	int bitcount;
+	uint8_t* out;
+	size_t outlen;
+	size_t outpos;
+	int error;
+} inflate_t;
+
+// canonical huffman decoding table
+#define MAX_CODE_BITS	15
+typedef struct huffman_s {
+	short counts[MAX_CODE_BITS + 1];	// number of codes of each length
+	short symbols[288];					// symbols ordered by code
+} huffman_t;
+
+// base lengths/distances and extra bits for length codes 257-285 and distance codes 0-29
+static const short length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const short length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const short dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const short dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+
+// read count bits from the input stream
+static int inflate_bits(inflate_t* s, int count) {
+	uint32_t val = s->bitbuf;
+
+	while (s->bitcount < count) {
+		if (s->inpos >= s->inlen) {
+			s->error = 1;
+			return 0;
+		}
+		val |= (uint32_t)s->in[s->inpos++] << s->bitcount;
+		s->bitcount += 8;
+	}
+
+	s->bitbuf = val >> count;
+	s->bitcount -= count;
+	return (int)(val & ((1u << count) - 1));
+}
+
+
+// build a decoding table from code lengths, returns 0 if the code is over-subscribed
+static int inflate_build(huffman_t* huff, const short* lengths, int n) {
+	short offsets[MAX_CODE_BITS + 1];
+	int left = 1;
+
+	memset(huff->counts, 0, sizeof(huff->counts));
+	for (int i = 0; i < n; i++)
+		huff->counts[lengths[i]]++;
+	if (huff->counts[0] == n)
+		return 1;
+
+	for (int len = 1; len <= MAX_CODE_BITS; len++) {
+		left <<= 1;
+		left -= huff->counts[len];
+		if (left < 0)
+			return 0;
+	}
+
+	offsets[1] = 0;
+	for (int len = 1; len < MAX_CODE_BITS; len++)
+		offsets[len + 1] = offsets[len] + huff->counts[len];
+	for (int i = 0; i < n; i++) {
+		if (lengths[i])
+			huff->symbols[offsets[lengths[i]]++] = (short)i;
+	}
+
+	return 1;
+}
+
+
+// decode one symbol using a huffman table
+static int inflate_decode(inflate_t* s, const huffman_t* huff) {
+	int code = 0;
+	int first = 0;
+	int index = 0;
+
+	for (int len = 1; len <= MAX_CODE_BITS; len++) {
+		code |= inflate_bits(s, 1);
+		if (s->error)
+			return -1;
+		int count = huff->counts[len];
+		if (code - count < first)
+			return huff->symbols[index + (code - first)];
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+
+	s->error = 1;
+	return -1;
+}
+
+
+// decode literal/length and distance codes until end of block
+static int inflate_codes(inflate_t* s, const huffman_t* lencode, const huffman_t* distcode) {
+	int symbol;
+
+	do {
+		symbol = inflate_decode(s, lencode);
+		if (symbol < 0)
+			return 0;
+
+		if (symbol < 256) {
+			if (s->outpos >= s->outlen)
+				return 0;
+			s->out[s->outpos++] = (uint8_t)symbol;
+		}
+		else if (symbol > 256) {
+			int len, dist;
+			symbol -= 257;
+			if (symbol >= 29)
+				return 0;
+			len = length_base[symbol] + inflate_bits(s, length_extra[symbol]);
+
+			symbol = inflate_decode(s, distcode);
+			if (symbol < 0 || symbol >= 30)
+				return 0;
+			dist = dist_base[symbol] + inflate_bits(s, dist_extra[symbol]);
+			if (s->error || (size_t)dist > s->outpos || s->outpos + len > s->outlen)
+				return 0;
+
+			// copy byte by byte since the source may overlap the destination
+			while (len--) {
+				s->out[s->outpos] = s->out[s->outpos - dist];
+				s->outpos++;
+			}
+		}
+	} while (symbol != 256);
+
+	return 1;
+}
+
+
+// stored (uncompressed) block
+static int inflate_stored(inflate_t* s) {
+	size_t len;
+
+	// discard remaining bits in current byte
+	s->bitbuf = 0;
+	s->bitcount = 0;
+
+	if (s->inpos + 4 > s->inlen)
+		return 0;
+	len = s->in[s->inpos] | (s->in[s->inpos + 1] << 8);
+	if ((unsigned)(s->in[s->inpos + 2] | (s->in[s->inpos + 3] << 8)) != (unsigned)(~len & 0xFFFF))
+		return 0;
+	s->inpos += 4;
+
+	if (s->inpos + len > s->inlen || s->outpos + len > s->outlen)
+		return 0;
+	memcpy(s->out + s->outpos, s->in + s->inpos, len);
+	s->inpos += len;
+	s->outpos += len;
+	return 1;
+}
+
+
+// block compressed with the fixed huffman codes
+static int inflate_fixed(inflate_t* s) {
+	static huffman_t lencode, distcode;
+	static int built = 0;
+
+	if (!built) {
+		short lengths[288];
+		int i;
+		for (i = 0; i < 144; i++)
+			lengths[i] = 8;
+		for (; i < 256; i++)
+			lengths[i] = 9;
+		for (; i < 280; i++)
+			lengths[i] = 7;
+		for (; i < 288; i++)
+			lengths[i] = 8;
+		inflate_build(&lencode, lengths, 288);
+		for (i = 0; i < 30; i++)
+			lengths[i] = 5;
+		inflate_build(&distcode, lengths, 30);
+		built = 1;
+	}
+
+	return inflate_codes(s, &lencode, &distcode);
+}
+
+
+// block compressed with huffman codes given in the block header
+static int inflate_dynamic(inflate_t* s) {
+	static const short order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+	short lengths[320];
+	huffman_t lencode, distcode;
+	int nlen, ndist, ncode;
+	int index;
+
+	nlen = inflate_bits(s, 5) + 257;
+	ndist = inflate_bits(s, 5) + 1;
+	ncode = inflate_bits(s, 4) + 4;
+	if (s->error || nlen > 286 || ndist > 30)
+		return 0;
+
+	// code length code lengths
+	for (index = 0; index < ncode; index++)
+		lengths[order[index]] = (short)inflate_bits(s, 3);
+	for (; index < 19; index++)
+		lengths[order[index]] = 0;
+	if (s->error || !inflate_build(&lencode, lengths, 19))
+		return 0;
+
+	// literal/length and distance code lengths
+	index = 0;
+	while (index < nlen + ndist) {
+		int symbol = inflate_decode(s, &lencode);
+		int len = 0;
+		int repeat;
+
+		if (symbol < 0)
+			return 0;
+		if (symbol < 16) {
+			lengths[index++] = (short)symbol;
+			continue;
+		}
+		if (symbol == 16) {
+			if (!index)
+				return 0;
+			len = lengths[index - 1];
+			repeat = 3 + inflate_bits(s, 2);
+		}
+		else if (symbol == 17)
+			repeat = 3 + inflate_bits(s, 3);
+		else
+			repeat = 11 + inflate_bits(s, 7);
+		if (s->error || index + repeat > nlen + ndist)
+			return 0;
+		while (repeat--)
+			lengths[index++] = (short)len;
+	}
+
+	// end of block code is required
+	if (!lengths[256])
+		return 0;
+
+	if (!inflate_build(&lencode, lengths, nlen) || !inflate_build(&distcode, lengths + nlen, ndist))
+		return 0;
+
+	return inflate_codes(s, &lencode, &distcode);
+}
+
+
+// decompress a raw deflate stream into out (outlen bytes), returns 1 on success
+int inflate_buf(const uint8_t* in, size_t inlen, uint8_t* out, size_t outlen) {
+	inflate_t s;
+	int last;
+
+	memset(&s, 0, sizeof(s));
+	s.in = in;
+	s.inlen = inlen;
+	s.out = out;
+	s.outlen = outlen;
+
+	do {
+		int type;
+		int ok;
+
+		last = inflate_bits(&s, 1);
+		type = inflate_bits(&s, 2);
+		if (s.error)
+			return 0;
+
+		if (type == 0)
+			ok = inflate_stored(&s);
+		else if (type == 1)
+			ok = inflate_fixed(&s);
+		else if (type == 2)
+			ok = inflate_dynamic(&s);
+		else
+			ok = 0;
+
+		if (!ok || s.error)
+			return 0;
+	} while (!last);
+
+	return s.outpos == outlen;
+}
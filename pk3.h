@@ -0,0 +1,53 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_PK3_H
+#define QVMOPS_PK3_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// largest entry pk3_read will decompress (qvms and maps are far smaller)
+#define PK3_MAX_ENTRY	(64 << 20)
+
+// a file stored in a pk3
+typedef struct pk3entry_s {
+	char* name;
+	int method;				// 0 = stored, 8 = deflate
+	uint32_t crc;
+	uint32_t compsize;
+	uint32_t size;
+	uint32_t offset;		// offset of local file header
+} pk3entry_t;
+
+// an open pk3 (zip) file
+typedef struct pk3_s {
+	FILE* h;
+	pk3entry_t* entries;
+	int entrycount;
+	long filesize;
+} pk3_t;
+
+// open a pk3 and read its central directory
+int pk3_open(const char* file, pk3_t* pk3);
+void pk3_close(pk3_t* pk3);
+
+// find an entry by name (case-insensitive), or NULL
+pk3entry_t* pk3_find(pk3_t* pk3, const char* name);
+
+// read and decompress an entry into a newly allocated buffer
+uint8_t* pk3_read(pk3_t* pk3, pk3entry_t* entry, int* size);
+
+// decompress a raw deflate stream into out (outlen bytes), returns 1 on success
+int inflate_buf(const uint8_t* in, size_t inlen, uint8_t* out, size_t outlen);
+
+#endif // QVMOPS_PK3_H
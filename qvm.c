@@ -15,6 +15,9 @@ Created By:
 #include <string.h>
 #include <malloc.h>
 #include "qvm.h"
+#include "stats.h"
+#include "util.h"
+#include "jumptable.h"
 
 vmheader_t header;
 
@@ -23,14 +26,55 @@ int instructioncount;
 
 uint8_t* data;
 int datasize[SEGMENT_COUNT];
+uint32_t qvmcrc;
+uint32_t codecrc;
+
+function_t functions[MAX_FUNCTIONS];
+int functioncount;
+
+int lazydecode;
+
+// lazy decoding state: a copy of the code segment, the byte offset of every DECODE_INTERVAL'th instruction,
+// and the most recently used blocks of DECODE_INTERVAL decoded instructions
+typedef struct decodeblock_s {
+	int block;			// block number, or -1 if empty
+	uint32_t used;		// decodetick when last used
+	instruction_t instrs[DECODE_INTERVAL];
+} decodeblock_t;
+
+static uint8_t* lazycode;
+static int* checkpoints;
+static decodeblock_t decodecache[DECODE_CACHE];
+static uint32_t decodetick;
+
+
+// read an instruction's param of n bytes
+static int read_param(const uint8_t* p, int n) {
+	if (n == 1)
+		return (int)*p;
+	if (n == 4)
+		return *(const int*)p;
+	return 0;
+}
+
+
+// decode the instruction at p in a code segment, returning its size in bytes
+static int decode_instruction(const uint8_t* code, const uint8_t* p, instruction_t* instr) {
+	int n = opcodeparamsize(*p);
+
+	instr->offset = (int)(p - code);
+	instr->opcode = *p;
+	instr->param = read_param(p + 1, n);
+
+	return 1 + n;
+}
 
 
 int parse_qvm(const char* file) {
 	FILE* h;
-	uint8_t* qvm;
+	uint8_t* qvm = NULL;
 	int qvmsize;
-	uint8_t* p;
-	int n;
+	int ret;
 
 	printf("Opening %s...\n", file);
 
@@ -41,77 +85,123 @@ int parse_qvm(const char* file) {
 	}
 
 	// grab qvm file size
-	n = ftell(h);
 	fseek(h, 0, SEEK_END);
 	qvmsize = ftell(h);
-	fseek(h, n, SEEK_SET);
+	fseek(h, 0, SEEK_SET);
 
 	// allocate enough memory for the whole thing
 	qvm = (uint8_t*)malloc(qvmsize);
 	if (!qvm) {
 		fprintf(stderr, "Unable to allocate qvm memory block: %d\n", qvmsize);
-		goto fail;
+		fclose(h);
+		return 0;
 	}
 
 	// read the file into memory and close file
 	fread(qvm, 1, qvmsize, h);
 	fclose(h);
-	h = NULL;
+
+	ret = parse_qvm_buffer(qvm, qvmsize);
+
+	free(qvm);
+
+	return ret;
+}
+
+
+int parse_qvm_buffer(const uint8_t* qvm, int qvmsize) {
+	const uint8_t* p;
+	int n;
+
+	free_qvm();
+
+	if (qvmsize < (int)sizeof(vmheader_t)) {
+		fprintf(stderr, "Invalid QVM file: too small\n");
+		return 0;
+	}
 
 	memcpy(&header, qvm, sizeof(vmheader_t));
 
 	// if the magic number doesn't match, abort
 	if (header.magic != VM_MAGIC) {
 		fprintf(stderr, "Invalid QVM file: magic number mismatch\n");
-		goto fail;
+		return 0;
 	}
 
 	// if the segment lengths doesn't match the file size
 	if (qvmsize != sizeof(vmheader_t) + header.codelength + header.datalen + header.litlen) {
 		fprintf(stderr, "Invalid QVM file: file size doesn't match segment lengths\n");
-		goto fail;
+		return 0;
 	}
 
 	// if the header has false code segment info, abort
 	if (header.codeoffset < sizeof(vmheader_t) || header.codeoffset > qvmsize || header.codeoffset + header.codelength > qvmsize) {
 		fprintf(stderr, "Invalid QVM file: invalid code offset/length\n");
-		goto fail;
+		return 0;
 	}
 
 	// if the header has false data segment info, abort
 	if (header.dataoffset < sizeof(vmheader_t) || header.dataoffset > qvmsize || header.dataoffset + header.datalen + header.litlen > qvmsize) {
 		fprintf(stderr, "Invalid QVM file: invalid data offset/length\n");
-		goto fail;
+		return 0;
 	}
 
+	if (header.opcount > MAX_INSTRUCTIONS) {
+		fprintf(stderr, "Invalid QVM file: too many instructions (%d)\n", header.opcount);
+		return 0;
+	}
+
+	qvmcrc = crc32_buf(0, qvm, qvmsize);
+
 	// start pointer at start of code segment
 	p = qvm + header.codeoffset;
+	codecrc = crc32_buf(0, p, header.codelength);
+
+	// in lazy mode, keep the code segment to decode from later
+	if (lazydecode) {
+		lazycode = (uint8_t*)calloc(header.codelength + 4, 1);
+		checkpoints = (int*)malloc((header.opcount / DECODE_INTERVAL + 1) * sizeof(int));
+		if (!lazycode || !checkpoints) {
+			fprintf(stderr, "Unable to allocate code memory block: %d\n", header.codelength);
+			return 0;
+		}
+		memcpy(lazycode, p, header.codelength);
+	}
 
 	int op;
 
 	// loop through each instruction in qvm file
+	// in lazy mode only checkpoints and function boundaries are recorded, get_instruction decodes the rest on demand
 	for (int index = 0; index < header.opcount && p < qvm + header.codeoffset + header.codelength; ++index, ++instructioncount) {
 		op = *p;
-
-		instructions[index].offset = p - (qvm + header.codeoffset);
-		instructions[index].opcode = op;
-
-		++p;
-
 		n = opcodeparamsize(op);
-		if (n == 1)
-			instructions[index].param = (int)*p;
-		else if (n == 4)
-			instructions[index].param = *(int*)p;
-		else
-			instructions[index].param = 0;
 
-		p += n;
+		if (!lazydecode)
+			decode_instruction(qvm + header.codeoffset, p, &instructions[index]);
+		else if (index % DECODE_INTERVAL == 0)
+			checkpoints[index / DECODE_INTERVAL] = (int)(p - (qvm + header.codeoffset));
+
+		// each OP_ENTER ends the previous function and starts a new one
+		if (op == OP_ENTER && functioncount < MAX_FUNCTIONS) {
+			if (functioncount)
+				functions[functioncount - 1].end = index;
+			functions[functioncount].start = index;
+			functions[functioncount].framesize = read_param(p + 1, n);
+			functioncount++;
+		}
+
+		p += 1 + n;
 	}
 
+	if (functioncount)
+		functions[functioncount - 1].end = instructioncount;
+
+	if (!lazydecode)
+		stats.instructions_decoded += instructioncount;
+
 	if (instructioncount != header.opcount) {
 		fprintf(stderr, "Invalid QVM file: couldn't read %d instructions\n", header.opcount);
-		goto fail;
+		return 0;
 	}
 
 	// copy data segments for later examination
@@ -119,17 +209,121 @@ int parse_qvm(const char* file) {
 	datasize[SEGMENT_LIT] = header.litlen;
 	datasize[SEGMENT_BSS] = header.bsslen;
 
-	data = malloc(header.datalen + header.litlen);
+	data = malloc(header.datalen + header.litlen + 1);
+	if (!data) {
+		fprintf(stderr, "Unable to allocate data memory block: %d\n", header.datalen + header.litlen);
+		return 0;
+	}
 	memcpy(data, qvm + header.dataoffset, header.datalen + header.litlen);
 
-	free(qvm);
+	// switch tables are part of the control flow every analysis needs
+	// (lazy disassembly recovers each one when its OP_JUMP is printed instead)
+	if (!lazydecode)
+		find_jumptables();
 
 	return 1;
-fail:
-	free(qvm);
-	if (h)
-		fclose(h);
-	return 0;
+}
+
+
+// free data from a previously loaded qvm
+void free_qvm(void) {
+	free(data);
+	data = NULL;
+	memset(datasize, 0, sizeof(datasize));
+	instructioncount = 0;
+	functioncount = 0;
+	jumptablecount = 0;
+
+	free(lazycode);
+	lazycode = NULL;
+	free(checkpoints);
+	checkpoints = NULL;
+	for (int i = 0; i < DECODE_CACHE; i++)
+		decodecache[i].block = -1;
+}
+
+
+// get a decoded instruction, decoding its block from the nearest checkpoint in lazy mode
+// in lazy mode the pointer is only good until DECODE_CACHE other blocks have been decoded
+// indexes outside the code segment (e.g. unchecked branch targets) give an OP_UNDEF
+instruction_t* get_instruction(int index) {
+	static instruction_t undef;
+	decodeblock_t* slot = &decodecache[0];
+	int block = index / DECODE_INTERVAL;
+	int start = block * DECODE_INTERVAL;
+	const uint8_t* p;
+
+	if (index < 0 || index >= instructioncount) {
+		memset(&undef, 0, sizeof(undef));
+		undef.opcode = OP_UNDEF;
+		return &undef;
+	}
+
+	if (!lazycode)
+		return &instructions[index];
+
+	decodetick++;
+	for (int i = 0; i < DECODE_CACHE; i++) {
+		if (decodecache[i].block == block) {
+			decodecache[i].used = decodetick;
+			return &decodecache[i].instrs[index - start];
+		}
+		// otherwise replace an empty or the least recently used block
+		if (slot->block >= 0 && (decodecache[i].block < 0 || decodecache[i].used < slot->used))
+			slot = &decodecache[i];
+	}
+
+	p = lazycode + checkpoints[block];
+	for (int i = 0; i < DECODE_INTERVAL && start + i < instructioncount; i++) {
+		p += decode_instruction(lazycode, p, &slot->instrs[i]);
+		stats.instructions_decoded++;
+	}
+	slot->block = block;
+	slot->used = decodetick;
+
+	return &slot->instrs[index - start];
+}
+
+
+// find the function containing an instruction index
+function_t* find_function(int index) {
+	int lo = 0;
+	int hi = functioncount - 1;
+
+	if (!functioncount || index < functions[0].start || index >= instructioncount)
+		return NULL;
+
+	// find the last function that starts at or before index
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		if (functions[mid].start <= index)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	return &functions[lo];
+}
+
+
+// find the instruction containing a code segment byte offset
+int find_instruction_by_offset(int offset) {
+	int lo = 0;
+	int hi = instructioncount - 1;
+
+	if (!instructioncount || offset < 0)
+		return -1;
+
+	// find the last instruction that starts at or before offset
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		if (get_instruction(mid)->offset <= offset)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	return lo;
 }
 
 
@@ -295,3 +489,86 @@ int opcodeparamsize(vmop_t op) {
 		return 0;
 	}
 }
+
+
+// number of operand stack entries an opcode pops and pushes
+// a function's return value is left on the stack by OP_LEAVE and replaces the call target at OP_CALL
+void opcodestack(vmop_t op, int* pops, int* pushes) {
+	switch (op) {
+	case OP_PUSH:
+	case OP_CONST:
+	case OP_LOCAL:
+		*pops = 0;
+		*pushes = 1;
+		return;
+	case OP_POP:
+	case OP_LEAVE:
+	case OP_JUMP:
+	case OP_ARG:
+		*pops = 1;
+		*pushes = 0;
+		return;
+	case OP_CALL:
+	case OP_LOAD1:
+	case OP_LOAD2:
+	case OP_LOAD4:
+	case OP_SEX8:
+	case OP_SEX16:
+	case OP_NEGI:
+	case OP_BCOM:
+	case OP_NEGF:
+	case OP_CVIF:
+	case OP_CVFI:
+		*pops = 1;
+		*pushes = 1;
+		return;
+	case OP_EQ:
+	case OP_NE:
+	case OP_LTI:
+	case OP_LEI:
+	case OP_GTI:
+	case OP_GEI:
+	case OP_LTU:
+	case OP_LEU:
+	case OP_GTU:
+	case OP_GEU:
+	case OP_EQF:
+	case OP_NEF:
+	case OP_LTF:
+	case OP_LEF:
+	case OP_GTF:
+	case OP_GEF:
+	case OP_STORE1:
+	case OP_STORE2:
+	case OP_STORE4:
+	case OP_BLOCK_COPY:
+		*pops = 2;
+		*pushes = 0;
+		return;
+	case OP_ADD:
+	case OP_SUB:
+	case OP_DIVI:
+	case OP_DIVU:
+	case OP_MODI:
+	case OP_MODU:
+	case OP_MULI:
+	case OP_MULU:
+	case OP_BAND:
+	case OP_BOR:
+	case OP_BXOR:
+	case OP_LSH:
+	case OP_RSHI:
+	case OP_RSHU:
+	case OP_ADDF:
+	case OP_SUBF:
+	case OP_DIVF:
+	case OP_MULF:
+		*pops = 2;
+		*pushes = 1;
+		return;
+	default:
+		*pops = 0;
+		*pushes = 0;
+		return;
+	}
+}
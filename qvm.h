@@ -15,6 +15,9 @@ Created By:
 
 #include <stdint.h>
 
+// size of the program stack the engine allocates at the end of the data image
+#define PROGRAM_STACK_SIZE	0x10000
+
 // magic numbers at start of .qvm
 // .qvm is generated with little endian order
 // magic number appears in file as 44 14 72 12
@@ -81,7 +84,8 @@ typedef enum vmop_e {
 	OP_DIVF,
 	OP_MULF,
 	OP_CVIF,
-	OP_CVFI
+	OP_CVFI,
+	OP_COUNT
 } vmop_t;
 
 // QVM header
@@ -98,6 +102,7 @@ typedef struct vmheader_s {
 
 const char* opcodename(vmop_t op);
 int opcodeparamsize(vmop_t op);
+void opcodestack(vmop_t op, int* pops, int* pushes);
 
 // segment numbers
 enum {
@@ -120,11 +125,44 @@ typedef struct instruction_s {
 extern instruction_t instructions[MAX_INSTRUCTIONS];
 extern int instructioncount;
 
+// when set before parse_qvm, instructions isn't filled and get_instruction decodes blocks of
+// DECODE_INTERVAL instructions on demand, keeping the DECODE_CACHE most recently used
+extern int lazydecode;
+#define DECODE_INTERVAL	64
+#define DECODE_CACHE	32
+
 extern uint8_t* data;
 extern int datasize[SEGMENT_COUNT];
+// CRC-32 of the whole file, and of the code segment as stored in the file, to tie sidecar files to a qvm
+extern uint32_t qvmcrc;
+extern uint32_t codecrc;
+
+#define MAX_FUNCTIONS 50000
+// a function in the code segment, as bounded by OP_ENTER instructions
+typedef struct function_s {
+	int start;			// instruction index of OP_ENTER
+	int end;			// instruction index after the last instruction
+	int framesize;		// OP_ENTER param
+} function_t;
+extern function_t functions[MAX_FUNCTIONS];
+extern int functioncount;
 
 // fill instructions array
 int parse_qvm(const char* file);
+int parse_qvm_buffer(const uint8_t* qvm, int qvmsize);
+
+// free data from a previously loaded qvm
+void free_qvm(void);
+
+// get a decoded instruction (from instructions, or decoded on demand in lazy mode)
+// indexes outside the code segment give an OP_UNDEF instruction
+instruction_t* get_instruction(int index);
+
+// find the function containing an instruction index
+function_t* find_function(int index);
+
+// find the instruction containing a code segment byte offset
+int find_instruction_by_offset(int offset);
 
 
 #endif // QVMOPS_QVM_H
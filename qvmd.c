@@ -0,0 +1,141 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "qvm.h"
+#include "analysis.h"
+#include "rewrite.h"
+#include "qvmd.h"
+
+
+// pad file with zeros up to the next table boundary, returning the new position
+static uint32_t qvmd_align(FILE* h, uint32_t pos) {
+	static const uint8_t zeros[QVMD_ALIGN] = { 0, };
+	uint32_t pad = (QVMD_ALIGN - pos % QVMD_ALIGN) % QVMD_ALIGN;
+	fwrite(zeros, 1, pad, h);
+	return pos + pad;
+}
+
+
+// write the currently loaded qvm as a .qvmd file
+int write_qvmd(const char* file) {
+	FILE* h = NULL;
+	qvmdheader_t qheader;
+	qvmdinstruction_t* records = NULL;
+	int32_t* targets = NULL;
+	uint32_t pos;
+	int ok = 0;
+
+	printf("Writing %s...\n", file);
+
+	records = (qvmdinstruction_t*)calloc(instructioncount + 1, sizeof(qvmdinstruction_t));
+	targets = (int32_t*)malloc((instructioncount + 1) * sizeof(int32_t));
+	if (!records || !targets) {
+		fprintf(stderr, "Unable to allocate qvmd memory\n");
+		goto done;
+	}
+
+	// decode flags for each instruction
+	for (int index = 0; index < instructioncount; index++) {
+		int target;
+		records[index].opcode = (uint8_t)instructions[index].opcode;
+		records[index].param = instructions[index].param;
+		if (instructions[index].opcode == OP_ENTER)
+			records[index].flags |= QVMD_FUNCTION;
+		target = branch_target(index);
+		if (target >= 0)
+			records[target].flags |= QVMD_BRANCH;
+		// a function pointer, rather than a direct call or jump
+		if (instructions[index].opcode == OP_CONST && is_code_ref(index) && target < 0
+			&& (index + 1 >= instructioncount || instructions[index + 1].opcode != OP_CALL))
+			records[instructions[index].param].flags |= QVMD_ADDRESS;
+	}
+	for (int address = 0; address + 4 <= datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT]; address += 4) {
+		int value;
+		if (!is_data_code_ref(address))
+			continue;
+		memcpy(&value, data + address, sizeof(int));
+		records[value].flags |= QVMD_ADDRESS;
+	}
+
+	memset(&qheader, 0, sizeof(qheader));
+	for (int index = 0; index < instructioncount; index++) {
+		if (records[index].flags)
+			targets[qheader.targetcount++] = index;
+	}
+
+	qheader.magic = QVMD_MAGIC;
+	qheader.version = QVMD_VERSION;
+	qheader.qvmcrc = qvmcrc;
+	qheader.codecrc = codecrc;
+	qheader.instructioncount = instructioncount;
+	qheader.functioncount = functioncount;
+	qheader.codelength = header.codelength;
+	qheader.datalen = header.datalen;
+	qheader.litlen = header.litlen;
+	qheader.bsslen = header.bsslen;
+
+	// lay out tables
+	pos = sizeof(qheader);
+	qheader.instructionsofs = pos;
+	pos += instructioncount * sizeof(qvmdinstruction_t);
+	qheader.offsetsofs = pos;
+	pos += (instructioncount + 1) * sizeof(uint32_t);
+	pos = (pos + QVMD_ALIGN - 1) / QVMD_ALIGN * QVMD_ALIGN;
+	qheader.targetsofs = pos;
+	pos += qheader.targetcount * sizeof(int32_t);
+	pos = (pos + QVMD_ALIGN - 1) / QVMD_ALIGN * QVMD_ALIGN;
+	qheader.functionsofs = pos;
+	pos += functioncount * sizeof(qvmdfunction_t);
+	qheader.dataofs = pos;
+
+	h = fopen(file, "wb");
+	if (!h) {
+		fprintf(stderr, "Unable to open %s for writing\n", file);
+		goto done;
+	}
+
+	fwrite(&qheader, sizeof(qheader), 1, h);
+	fwrite(records, sizeof(qvmdinstruction_t), instructioncount, h);
+	pos = qheader.offsetsofs;
+	for (int index = 0; index <= instructioncount; index++) {
+		uint32_t offset = index < instructioncount ? (uint32_t)instructions[index].offset : (uint32_t)header.codelength;
+		fwrite(&offset, sizeof(offset), 1, h);
+		pos += sizeof(offset);
+	}
+	pos = qvmd_align(h, pos);
+	fwrite(targets, sizeof(int32_t), qheader.targetcount, h);
+	pos = qvmd_align(h, pos + qheader.targetcount * sizeof(int32_t));
+	for (int f = 0; f < functioncount; f++) {
+		qvmdfunction_t qfunc;
+		qfunc.start = functions[f].start;
+		qfunc.end = functions[f].end;
+		qfunc.framesize = functions[f].framesize;
+		qfunc.reserved = 0;
+		fwrite(&qfunc, sizeof(qfunc), 1, h);
+	}
+	fwrite(data, 1, header.datalen + header.litlen, h);
+
+	ok = !ferror(h);
+	if (!ok)
+		fprintf(stderr, "Error writing %s\n", file);
+
+done:
+	if (h)
+		fclose(h);
+	free(records);
+	free(targets);
+	return ok;
+}
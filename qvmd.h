@@ -0,0 +1,73 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_QVMD_H
+#define QVMOPS_QVMD_H
+
+#include <stdint.h>
+
+// magic number at start of .qvmd files ("QVMD")
+#define QVMD_MAGIC		0x444D5651
+#define QVMD_VERSION	1
+// every table starts on a multiple of this, so the file can be mapped and used in place
+#define QVMD_ALIGN		8
+
+// .qvmd file layout (little endian):
+//   qvmdheader_t
+//   qvmdinstruction_t[instructioncount], by instruction index
+//   uint32_t[instructioncount + 1] code segment byte offset of each instruction, then the code length
+//   int32_t[targetcount] instruction indexes that may be jumped or called to, ascending
+//   qvmdfunction_t[functioncount], by instruction index
+//   datalen + litlen bytes of initialized data, as in the qvm
+// all offsets are from the start of the file
+typedef struct qvmdheader_s {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t qvmcrc;			// CRC-32 of the whole source qvm
+	uint32_t codecrc;			// CRC-32 of the source code segment
+	int32_t instructioncount;
+	int32_t targetcount;
+	int32_t functioncount;
+	int32_t codelength;
+	int32_t datalen;
+	int32_t litlen;
+	int32_t bsslen;
+	uint32_t instructionsofs;
+	uint32_t offsetsofs;
+	uint32_t targetsofs;
+	uint32_t functionsofs;
+	uint32_t dataofs;
+} qvmdheader_t;
+
+// qvmdinstruction_t flags
+#define QVMD_FUNCTION	0x01	// OP_ENTER starting a function
+#define QVMD_BRANCH		0x02	// target of a branch or constant OP_JUMP
+#define QVMD_ADDRESS	0x04	// address is stored (function pointer, or switch table entry)
+
+typedef struct qvmdinstruction_s {
+	uint8_t opcode;
+	uint8_t flags;
+	uint16_t reserved;
+	int32_t param;
+} qvmdinstruction_t;
+
+typedef struct qvmdfunction_s {
+	int32_t start;				// instruction index of OP_ENTER
+	int32_t end;				// instruction index after the last instruction
+	int32_t framesize;			// OP_ENTER param
+	int32_t reserved;
+} qvmdfunction_t;
+
+// write the currently loaded qvm as a .qvmd file
+int write_qvmd(const char* file);
+
+#endif // QVMOPS_QVMD_H
@@ -16,120 +16,651 @@ Created By:
 
 #include "qvm.h"
 #include "symbols.h"
+#include "output.h"
+#include "cost.h"
+#include "traps.h"
+#include "pk3.h"
+#include "verify.h"
+#include "rewrite.h"
+#include "strip.h"
+#include "ngrams.h"
+#include "watch.h"
+#include "index.h"
+#include "stack.h"
+#include "globals.h"
+#include "search.h"
+#include "jobs.h"
+#include "sigdb.h"
+#include "bounds.h"
+#include "qvmd.h"
+#include "reorder.h"
+#include "litmerge.h"
+#include "size.h"
+#include "inline.h"
+#include "opstack.h"
+#include "jumptable.h"
+#include "effects.h"
+#include "stats.h"
 #include "util.h"
 #include "qvmops.h"
 
 
+static int process_file(int item);
+static int process_input(const char* input, const char* mapfile);
+static int process_pk3(const char* pk3file, const char* entryname);
+static int process_output(const char* name, const char* outfile);
 static int process(const char* file);
+static int process_watch(const char* qvmfile, const char* mapfile);
+static int select_code(int* start, int* end);
+
+options_t options;
+
+// input files, for process_file
+static const char** inputs;
 
 
 int main(int argc, char* argv[]) {
-	char qvmfile[1024];
-	char mapfile[1024];
-	char outfile[1024];
-	int n = 0;
-	int ret = 0;			
+	const char** files;
+	int filecount = 0;
+	int ret = 0;
 
 	printf("qvmops v" QVMOPS_VERSION "\n\n");
+
+	files = (const char**)calloc(argc, sizeof(const char*));
+	if (!files)
+		return 1;
+
+	// separate options from filenames
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--stats"))
+			options.stats = STATS_TEXT;
+		else if (!strcmp(argv[i], "--stats=json"))
+			options.stats = STATS_JSON;
+		else if (!strncmp(argv[i], "--stats=json=", 13) && argv[i][13]) {
+			options.stats = STATS_JSON;
+			options.statsfile = argv[i] + 13;
+		}
+		else if (!strcmp(argv[i], "--func") && i + 1 < argc)
+			options.func = argv[++i];
+		else if (!strcmp(argv[i], "--range") && i + 1 < argc)
+			options.range = argv[++i];
+		else if (!strcmp(argv[i], "--data") && i + 1 < argc)
+			options.data = argv[++i];
+		else if (!strcmp(argv[i], "--cost"))
+			options.cost = 1;
+		else if (!strcmp(argv[i], "--traps"))
+			options.traps = 1;
+		else if (!strcmp(argv[i], "--gzip"))
+			options.gzip = COMPRESS_GZIP;
+		else if (!strcmp(argv[i], "--gzip=thread"))
+			options.gzip = COMPRESS_GZIP_THREAD;
+		else if (!strcmp(argv[i], "--verify"))
+			options.verify = 1;
+		else if (!strcmp(argv[i], "--verify-log") && i + 1 < argc) {
+			options.verify = 1;
+			options.verifylog = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--fail-fast"))
+			options.failfast = 1;
+		else if (!strcmp(argv[i], "--strip"))
+			options.strip = 1;
+		else if (!strcmp(argv[i], "--qvmd"))
+			options.qvmd = 1;
+		else if (!strcmp(argv[i], "--inline"))
+			options.inlining = 1;
+		else if (!strcmp(argv[i], "--inline-size") && i + 1 < argc) {
+			options.inlining = 1;
+			options.inlinesize = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--inline-growth") && i + 1 < argc) {
+			options.inlining = 1;
+			options.inlinegrowth = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--ambiguous") && i + 1 < argc) {
+			i++;
+			if (!strcmp(argv[i], "int"))
+				ambiguousrefs = AMBIGUOUS_INT;
+			else if (!strcmp(argv[i], "pointer"))
+				ambiguousrefs = AMBIGUOUS_POINTER;
+			else {
+				fprintf(stderr, "Invalid ambiguous value treatment: %s (must be int or pointer)\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "--merge-lit"))
+			options.mergelit = 1;
+		else if (!strcmp(argv[i], "--reorder"))
+			options.reorder = 1;
+		else if (!strcmp(argv[i], "--reorder-profile") && i + 1 < argc) {
+			options.reorder = 1;
+			options.reorderprofile = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--ngrams") && i + 1 < argc) {
+			options.ngrams = atoi(argv[++i]);
+			if (options.ngrams < 2 || options.ngrams > MAX_NGRAM) {
+				fprintf(stderr, "Invalid n-gram length: %s (must be 2-%d)\n", argv[i], MAX_NGRAM);
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "--ngrams-weighted"))
+			options.ngramweighted = 1;
+		else if (!strcmp(argv[i], "--watch"))
+			options.watch = 1;
+		else if (!strcmp(argv[i], "--index"))
+			options.index = 1;
+		else if (!strcmp(argv[i], "--search") && i + 1 < argc) {
+			if (!search_load(argv[++i]))
+				return 1;
+		}
+		else if (!strcmp(argv[i], "--pattern") && i + 1 < argc) {
+			if (!search_add(argv[++i]))
+				return 1;
+		}
+		else if (!strcmp(argv[i], "--jobs") && i + 1 < argc)
+			options.jobs = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--sigdb-add") && i + 1 < argc)
+			options.sigdbadd = argv[++i];
+		else if (!strcmp(argv[i], "--sigdb-match") && i + 1 < argc)
+			options.sigdbmatch = argv[++i];
+		else if (!strcmp(argv[i], "--sigdb-module") && i + 1 < argc)
+			options.sigdbmodule = argv[++i];
+		else if (!strcmp(argv[i], "--stack"))
+			options.stack = 1;
+		else if (!strcmp(argv[i], "--globals"))
+			options.globals = 1;
+		else if (!strcmp(argv[i], "--bounds"))
+			options.bounds = 1;
+		else if (!strcmp(argv[i], "--effects"))
+			options.effects = 1;
+		else if (!strcmp(argv[i], "--size"))
+			options.size = 1;
+		else if (!strcmp(argv[i], "--size-sort") && i + 1 < argc) {
+			options.size = 1;
+			options.sizesort = parse_size_sort(argv[++i]);
+			if (options.sizesort < 0) {
+				fprintf(stderr, "Invalid size sort: %s (must be bytes, instructions, name or address)\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "--size-diff"))
+			options.sizediff = 1;
+		else if (!strcmp(argv[i], "--types"))
+			options.types = 1;
+		else if (!strcmp(argv[i], "--lazy"))
+			options.lazy = 1;
+		else if (!strncmp(argv[i], "--", 2)) {
+			fprintf(stderr, "Unknown option: %s\n", argv[i]);
+			return 1;
+		}
+		else
+			files[filecount++] = argv[i];
+	}
 	
 	// require a filename parameter
-	if (argc < 2) {
-		fprintf(stderr, "Usage: %s <file> [mapfile]\n", argv[0]);
+	if (!filecount) {
+		fprintf(stderr, "Usage: %s [--stats[=json[=FILE]]] [--func NAME] [--range START:END] [--data SYMBOL] [--cost] [--traps] [--stack] [--globals] [--bounds] [--effects] [--size [--size-sort KEY]] [--types] [--lazy] [--gzip[=thread]] [--verify [--verify-log FILE] [--fail-fast]] [--strip] [--qvmd] [--reorder [--reorder-profile FILE]] [--inline [--inline-size N] [--inline-growth PERCENT]] [--merge-lit] [--ambiguous int|pointer] [--ngrams N [--ngrams-weighted]] [--size-diff [--size-sort KEY]] [--watch] [--index] [--search FILE] [--pattern PATTERN] [--jobs N] [--sigdb-add DB | --sigdb-match DB] [--sigdb-module NAME] <file> [mapfile]\n", argv[0]);
+		fprintf(stderr, "       %s [options] <file.qvm|archive.pk3|archive.pk3:path/file.qvm> ...\n", argv[0]);
 		return 1;
 	}
 
-	strncpyz(qvmfile, argv[1], sizeof(qvmfile));
+	// a single qvm may be followed by the map file to use with it
+	if (options.watch && filecount > 2) {
+		fprintf(stderr, "--watch only supports a single .qvm file\n");
+		return 1;
+	}
+	// watch output is split into a file per function, which the index doesn't describe
+	if (options.watch && options.index) {
+		fprintf(stderr, "--index isn't supported with --watch\n");
+		return 1;
+	}
+	// analyses and rewrites go through the whole instructions array
+	if (options.lazy && (options.cost || options.traps || options.stack || options.globals || options.bounds || options.effects || options.size || options.types
+		|| options.verify || options.strip || options.qvmd || options.reorder || options.inlining || options.mergelit || options.ngrams || options.sizediff
+		|| patterncount || options.sigdbadd || options.sigdbmatch)) {
+		fprintf(stderr, "--lazy only supports disassembly\n");
+		return 1;
+	}
+	lazydecode = options.lazy;
+	if (options.verifylog) {
+		verifylog = fopen(options.verifylog, "w");
+		if (!verifylog) {
+			fprintf(stderr, "Unable to open %s for writing\n", options.verifylog);
+			return 1;
+		}
+	}
+	if (filecount == 2 && !striendswith(files[1], ".qvm") && !striendswith(files[1], ".pk3") && !strstr(files[1], ".pk3:")) {
+		if (!process_input(files[0], files[1]))
+			ret = 1;
+	}
+	// n-gram counts, size profiles, new signatures and stats are kept in memory until all inputs are done, so they can't be split across processes
+	else if (options.jobs > 1 && !options.ngrams && !options.sizediff && !options.sigdbadd && !options.stats) {
+		inputs = files;
+		if (!run_jobs(options.jobs, filecount, process_file, options.failfast))
+			ret = 1;
+	}
+	else {
+		for (int i = 0; i < filecount; i++) {
+			if (!process_input(files[i], NULL)) {
+				ret = 1;
+				if (options.failfast)
+					break;
+			}
+		}
+	}
+
+	if (options.ngrams)
+		report_ngrams(stdout);
+
+	if (options.sizediff && !report_size_diff(stdout, options.sizesort))
+		ret = 1;
+
+	if (options.sigdbadd && !sigdb_save())
+		ret = 1;
+
+	// json goes somewhere progress output doesn't, so it can be parsed
+	if (options.stats == STATS_TEXT)
+		stats_report(stdout, 0);
+	else if (options.stats == STATS_JSON && !options.statsfile)
+		stats_report(stderr, 1);
+	else if (options.stats == STATS_JSON) {
+		FILE* h = fopen(options.statsfile, "w");
+		if (!h) {
+			fprintf(stderr, "Unable to open %s for writing\n", options.statsfile);
+			ret = 1;
+		}
+		else {
+			stats_report(h, 1);
+			fclose(h);
+		}
+	}
+
+	if (verifylog)
+		fclose(verifylog);
+
+	free(files);
+
+	return ret;
+}
+
+
+// process one of the input files given on the command line (run_jobs callback)
+static int process_file(int item) {
+	return process_input(inputs[item], NULL);
+}
+
+
+// load and process a qvm file, a pk3 file (every qvm in it), or a qvm inside a pk3 ("archive.pk3:vm/qagame.qvm")
+static int process_input(const char* input, const char* mapfile) {
+	char qvmfile[1024];
+	char mapbuf[1024];
+	char outfile[1024];
+	char* sep;
+	int ret;
+
+	strncpyz(qvmfile, input, sizeof(qvmfile));
+
+	// look for a file inside a pk3
+	sep = strstr(qvmfile, ".pk3:");
+	if (!sep)
+		sep = strstr(qvmfile, ".PK3:");
+	if (sep) {
+		sep[4] = '\0';
+		return process_pk3(qvmfile, sep + 5);
+	}
+	if (striendswith(qvmfile, ".pk3"))
+		return process_pk3(qvmfile, NULL);
 
 	// if no map filename given, look for qvm filename with .map extension
-	if (argc == 2) {
-		strncpyz(mapfile, argv[1], sizeof(mapfile));
+	if (!mapfile) {
+		strncpyz(mapbuf, qvmfile, sizeof(mapbuf));
 		// look for ".qvm"
-		char* p = strrstr(mapfile, ".qvm");
+		char* p = strrstr(mapbuf, ".qvm");
 		// if found
 		if (p)
 			// change to ".map"
 			memcpy(p, ".map", 4);
 		// otherwise, append ".map"
 		else
-			strncatz(mapfile, ".map", sizeof(mapfile));
+			strncatz(mapbuf, ".map", sizeof(mapbuf));
+		mapfile = mapbuf;
 	}
-	// otherwise use provided map filename
-	else
-		strncpyz(mapfile, argv[2], sizeof(mapfile));
+
+	if (options.watch)
+		return process_watch(qvmfile, mapfile);
 
 	// try to load map file
+	stats_begin(PHASE_PARSE_MAP);
 	parse_map(mapfile);
+	stats_end(PHASE_PARSE_MAP);
 
 	// try to load qvm file
-	if (!parse_qvm(qvmfile)) {
-		fprintf(stderr, "Failed to read QVM file %s", argv[1]);
-		return 1;
+	stats_begin(PHASE_PARSE_QVM);
+	ret = parse_qvm(qvmfile);
+	stats_end(PHASE_PARSE_QVM);
+	if (!ret) {
+		fprintf(stderr, "Failed to read QVM file %s\n", qvmfile);
+		if (options.verify)
+			verify_report(qvmfile, -1, "error", "invalid-file", "unable to load QVM");
+		return 0;
 	}
 
-	// open output file for writing
-	strncpyz(outfile, argv[1], sizeof outfile);
+	strncpyz(outfile, qvmfile, sizeof(outfile));
 	strncatz(outfile, ".txt", sizeof(outfile));
-	printf("Processing output file %s...\n", outfile);
-	process(outfile);
+	return process_output(qvmfile, outfile);
+}
+
+
+// load a qvm (and its map, if present) from inside a pk3 and process it
+static int process_pk3_entry(const char* pk3file, pk3_t* pk3, pk3entry_t* entry) {
+	char name[1024];
+	char mapname[1024];
+	char outfile[1024];
+	pk3entry_t* mapentry;
+	uint8_t* buf;
+	int size;
+	int ret;
+
+	printf("Reading %s from %s...\n", entry->name, pk3file);
+
+	// look for a map with the same name as the qvm
+	strncpyz(mapname, entry->name, sizeof(mapname));
+	if (strlen(mapname) >= 4)
+		memcpy(mapname + strlen(mapname) - 4, ".map", 4);
+	mapentry = pk3_find(pk3, mapname);
+
+	stats_begin(PHASE_PARSE_MAP);
+	if (mapentry && (buf = pk3_read(pk3, mapentry, &size))) {
+		printf("Reading %s from %s...\n", mapentry->name, pk3file);
+		parse_map_buffer((const char*)buf, size);
+		free(buf);
+	}
+	else {
+		fprintf(stderr, "File not found: %s:%s\n", pk3file, mapname);
+		free_map();
+	}
+	stats_end(PHASE_PARSE_MAP);
+
+	stats_begin(PHASE_PARSE_QVM);
+	buf = pk3_read(pk3, entry, &size);
+	ret = buf && parse_qvm_buffer(buf, size);
+	free(buf);
+	stats_end(PHASE_PARSE_QVM);
+	snprintf(name, sizeof(name), "%s:%s", pk3file, entry->name);
+	if (!ret) {
+		fprintf(stderr, "Failed to read QVM file %s\n", name);
+		if (options.verify)
+			verify_report(name, -1, "error", "invalid-file", "unable to load QVM");
+		return 0;
+	}
+
+	// output next to the pk3, with path separators flattened ("pak0.pk3_vm_qagame.qvm.txt")
+	snprintf(outfile, sizeof(outfile), "%s_%s.txt", pk3file, entry->name);
+	for (char* p = outfile + strlen(pk3file); *p; p++) {
+		if (*p == '/' || *p == '\\')
+			*p = '_';
+	}
+	return process_output(name, outfile);
+}
 
-	// cleanup
-	printf("%s written\n", outfile);
 
+// process a single qvm inside a pk3, or every qvm in it if entryname is NULL
+static int process_pk3(const char* pk3file, const char* entryname) {
+	pk3_t pk3;
+	int found = 0;
+	int ret = 1;
+
+	if (options.watch) {
+		fprintf(stderr, "--watch only supports .qvm files on disk\n");
+		return 0;
+	}
+
+	if (!pk3_open(pk3file, &pk3))
+		return 0;
+
+	for (int i = 0; i < pk3.entrycount; i++) {
+		pk3entry_t* entry = &pk3.entries[i];
+		if (entryname ? !striequal(entry->name, entryname) : !striendswith(entry->name, ".qvm"))
+			continue;
+		found = 1;
+		if (!process_pk3_entry(pk3file, &pk3, entry)) {
+			ret = 0;
+			if (options.failfast)
+				break;
+		}
+	}
+
+	if (!found) {
+		fprintf(stderr, "File not found: %s:%s\n", pk3file, entryname ? entryname : "*.qvm");
+		ret = 0;
+	}
+
+	pk3_close(&pk3);
 	return ret;
 }
 
 
+// output filename without ".qvm.txt", for files written instead of the disassembly
+static void output_base(char* base, size_t size, const char* outfile) {
+	char* p;
+	strncpyz(base, outfile, size);
+	if ((p = strrstr(base, ".txt")))
+		*p = '\0';
+	if ((p = strrstr(base, ".qvm")))
+		*p = '\0';
+}
+
+
+// module a qvm's system calls belong to for signature databases: --sigdb-module, or the file name without
+// any directory, pk3 or .qvm part ("qagame" for "mod.pk3:vm/qagame.qvm")
+static void module_name(char* module, size_t size, const char* name) {
+	const char* p;
+	char* ext;
+
+	if (options.sigdbmodule) {
+		strncpyz(module, options.sigdbmodule, size);
+		return;
+	}
+	for (p = name + strlen(name); p > name && p[-1] != '/' && p[-1] != '\\' && p[-1] != ':'; p--)
+		;
+	strncpyz(module, p, size);
+	if ((ext = strrstr(module, ".qvm")))
+		*ext = '\0';
+}
+
+
+// write output file for the currently loaded qvm (or just verify, strip, reorder, inline, merge or pre-decode it)
+static int process_output(const char* name, const char* outfile) {
+	char file[1024];
+
+	if (options.verify) {
+		int errors;
+		stats_begin(PHASE_VERIFY);
+		errors = verify_qvm(name);
+		stats_end(PHASE_VERIFY);
+		return !errors;
+	}
+
+	// only search for instruction patterns
+	if (patterncount) {
+		stats_begin(PHASE_SEARCH);
+		search_qvm(name);
+		stats_end(PHASE_SEARCH);
+		return 1;
+	}
+
+	// only count opcode sequences, to be reported once all inputs are done
+	if (options.ngrams) {
+		int start, end;
+		if (!select_code(&start, &end))
+			return 0;
+		stats_begin(PHASE_NGRAMS);
+		count_ngrams(start, end, options.ngrams, options.ngramweighted);
+		stats_end(PHASE_NGRAMS);
+		return 1;
+	}
+
+	// only keep per-function code sizes, to be compared once all inputs are done
+	if (options.sizediff) {
+		stats_begin(PHASE_REPORT_SIZE);
+		add_size_profile(name);
+		stats_end(PHASE_REPORT_SIZE);
+		return 1;
+	}
+
+	// add named functions to a signature database
+	if (options.sigdbadd) {
+		module_name(file, sizeof(file), name);
+		return sigdb_add(options.sigdbadd, file);
+	}
+
+	// write "name.matched.map" from a signature database instead of a disassembly
+	if (options.sigdbmatch) {
+		char module[1024];
+		module_name(module, sizeof(module), name);
+		output_base(file, sizeof(file), outfile);
+		strncatz(file, ".matched.map", sizeof(file));
+		return sigdb_match(options.sigdbmatch, file, module);
+	}
+
+	// write "name.stripped.qvm" and "name.stripped.map" instead of a disassembly
+	if (options.strip) {
+		char mapfile[1024];
+		output_base(file, sizeof(file), outfile);
+		strncpyz(mapfile, file, sizeof(mapfile));
+		strncatz(mapfile, ".stripped.map", sizeof(mapfile));
+		strncatz(file, ".stripped.qvm", sizeof(file));
+		return strip_qvm(file, mapfile);
+	}
+
+	// write "name.reordered.qvm" and "name.reordered.map" instead of a disassembly
+	if (options.reorder) {
+		char mapfile[1024];
+		output_base(file, sizeof(file), outfile);
+		strncpyz(mapfile, file, sizeof(mapfile));
+		strncatz(mapfile, ".reordered.map", sizeof(mapfile));
+		strncatz(file, ".reordered.qvm", sizeof(file));
+		return reorder_qvm(file, mapfile, options.reorderprofile);
+	}
+
+	// write "name.inlined.qvm" and "name.inlined.map" instead of a disassembly
+	if (options.inlining) {
+		char mapfile[1024];
+		output_base(file, sizeof(file), outfile);
+		strncpyz(mapfile, file, sizeof(mapfile));
+		strncatz(mapfile, ".inlined.map", sizeof(mapfile));
+		strncatz(file, ".inlined.qvm", sizeof(file));
+		return inline_qvm(file, mapfile, options.inlinesize ? options.inlinesize : INLINE_MAX_BODY,
+			options.inlinegrowth ? options.inlinegrowth : INLINE_MAX_GROWTH);
+	}
+
+	// write "name.merged.qvm" and "name.merged.map" instead of a disassembly
+	if (options.mergelit) {
+		char mapfile[1024];
+		output_base(file, sizeof(file), outfile);
+		strncpyz(mapfile, file, sizeof(mapfile));
+		strncatz(mapfile, ".merged.map", sizeof(mapfile));
+		strncatz(file, ".merged.qvm", sizeof(file));
+		return merge_lit(file, mapfile);
+	}
+
+	// write "name.qvmd" instead of a disassembly
+	if (options.qvmd) {
+		output_base(file, sizeof(file), outfile);
+		strncatz(file, ".qvmd", sizeof(file));
+		return write_qvmd(file);
+	}
+
+	strncpyz(file, outfile, sizeof(file));
+	if (options.gzip)
+		strncatz(file, ".gz", sizeof(file));
+
+	printf("Processing output file %s...\n", file);
+	if (!process(file))
+		return 0;
+
+	printf("%s written\n", file);
+	return 1;
+}
+
+
 // output header
-static void process_header(FILE* h) {
+static void process_header(output_t* h) {
 	puts("Processing header...");
 	// output header info
-	fputs("HEADER\n======\n", h);
-	fprintf(h, "MAGIC: %X\n", header.magic);
-	fprintf(h, "OPCOUNT: 0x%X (%i)\n", header.opcount, header.opcount);
-	fprintf(h, "CODEOFF: 0x%X (%i)\n", header.codeoffset, header.codeoffset);
-	fprintf(h, "CODELEN: 0x%X (%i)\n", header.codelength, header.codelength);
-	fprintf(h, "DATAOFF: 0x%X (%i)\n", header.dataoffset, header.dataoffset);
-	fprintf(h, "DATALEN: 0x%X (%i)\n", header.datalen, header.datalen);
-	fprintf(h, "LITLEN : 0x%X (%i)\n", header.litlen, header.litlen);
-	fprintf(h, "BSSLEN : 0x%X (%i)\n", header.bsslen, header.bsslen);
+	out_puts(h, "HEADER\n======\n");
+	out_printf(h, "MAGIC: %X\n", header.magic);
+	out_printf(h, "OPCOUNT: 0x%X (%i)\n", header.opcount, header.opcount);
+	out_printf(h, "CODEOFF: 0x%X (%i)\n", header.codeoffset, header.codeoffset);
+	out_printf(h, "CODELEN: 0x%X (%i)\n", header.codelength, header.codelength);
+	out_printf(h, "DATAOFF: 0x%X (%i)\n", header.dataoffset, header.dataoffset);
+	out_printf(h, "DATALEN: 0x%X (%i)\n", header.datalen, header.datalen);
+	out_printf(h, "LITLEN : 0x%X (%i)\n", header.litlen, header.litlen);
+	out_printf(h, "BSSLEN : 0x%X (%i)\n", header.bsslen, header.bsslen);
 }
 
 
-// output code segment
-static int process_code(FILE* h) {
+// output code segment (instructions start through end, exclusive)
+static int process_code(output_t* h, int start, int end) {
 	int last_enter_index = -1;
 	int semicolon = 0;
 	symbolmap_t* symbol;
 	instruction_t* instr = NULL;
+	function_t* func;
 
-	puts("Processing code segment...");
-	fputs("\n\nCODE SEGMENT\n============\n", h);
-	fputs(" INDEX(XINDEX) OFFSET(XOFFSET) INSTR     PARAM\n", h);
+	out_puts(h, "\n\nCODE SEGMENT\n============\n");
+	if (start != 0 || end != instructioncount)
+		out_printf(h, "Instructions %d-%d of %d\n", start, end - 1, instructioncount);
+	if (options.types)
+		out_puts(h, " INDEX(XINDEX) OFFSET(XOFFSET) INSTR     PARAM      DEPTH T\n");
+	else
+		out_puts(h, " INDEX(XINDEX) OFFSET(XOFFSET) INSTR     PARAM\n");
+
+	// if starting partway through a function, OP_LEAVE still needs to know where it began
+	func = find_function(start);
+	if (func)
+		last_enter_index = func->start;
+
+	if (options.index)
+		index_begin(h->pos);
 
 	// output code info
-	for (int index = 0; index < instructioncount; index++) {
-		instr = &instructions[index];
+	for (int index = start; index < end; index++) {
+		instr = get_instruction(index);
 
 		semicolon = 0;
 
-		fprintf(h, "%06d(%06x) %06d(%07x) %-9s", index, index, instr->offset, instr->offset, opcodename(instr->opcode));
+		if (options.index) {
+			index_instruction(index, h->pos);
+			if (instr->opcode == OP_ENTER)
+				index_function(index, h->pos);
+		}
+
+		out_printf(h, "%06d(%06x) %06d(%07x) %-9s", index, index, instr->offset, instr->offset, opcodename(instr->opcode));
 
 		if (opcodeparamsize(instr->opcode))
-			fprintf(h, " %-10d", instr->param);
+			out_printf(h, " %-10d", instr->param);
 		else
-			fputs("           ", h);
+			out_puts(h, "           ");
+
+		// operand stack depth before the instruction, and type of the value it pushes
+		if (options.types) {
+			if (opdepth[index] == OPDEPTH_UNKNOWN)
+				out_printf(h, " %5s %c", "?", optype_char(optype[index]));
+			else
+				out_printf(h, " %5d %c", opdepth[index], optype_char(optype[index]));
+		}
 
 		switch (instr->opcode) {
 		case OP_ENTER: {
 			last_enter_index = index;
 			symbol = find_code_symbol(index, -1);
 			if (symbol)
-				fputs(" ;", h);
+				out_puts(h, " ;");
 			else
-				fprintf(h, " ; START func%d", index);
+				out_printf(h, " ; START func%d", index);
 			semicolon = 1;
 			while (symbol) {
-				fprintf(h, " START %s", symbol->symbol);
+				out_printf(h, " START %s", symbol->symbol);
 				symbol = find_code_symbol(index, symbol->index);
 			}
 			break;
@@ -139,12 +670,12 @@ static int process_code(FILE* h) {
 				break;
 			symbol = find_code_symbol(last_enter_index, -1);
 			if (symbol)
-				fputs(" ;", h);
+				out_puts(h, " ;");
 			else
-				fprintf(h, " ; END func%d", last_enter_index);
+				out_printf(h, " ; END func%d", last_enter_index);
 			semicolon = 1;
 			while (symbol) {
-				fprintf(h, " END %s", symbol->symbol);
+				out_printf(h, " END %s", symbol->symbol);
 				symbol = find_code_symbol(last_enter_index, symbol->index);
 			}
 			break;
@@ -153,23 +684,23 @@ static int process_code(FILE* h) {
 			instruction_t* prev_instr;
 			if (index == 0)
 				break;
-			prev_instr = &instructions[index - 1];
+			prev_instr = get_instruction(index - 1);
 			if (prev_instr->opcode != OP_CONST)
 				break;
 			if (prev_instr->param >= instructioncount)
 				break;
 			symbol = find_code_symbol(prev_instr->param, -1);
 			if (symbol)
-				fputs(" ;", h);
+				out_puts(h, " ;");
 			else {
 				if (prev_instr->param < 0)
-					fprintf(h, " ; > trap%d", -prev_instr->param - 1);
+					out_printf(h, " ; > trap%d", -prev_instr->param - 1);
 				else
-					fprintf(h, " ; > func%d", prev_instr->param);
+					out_printf(h, " ; > func%d", prev_instr->param);
 			}
 			semicolon = 1;
 			while (symbol) {
-				fprintf(h, " > %s", symbol->symbol);
+				out_printf(h, " > %s", symbol->symbol);
 				symbol = find_code_symbol(prev_instr->param, symbol->index);
 			}
 			break;
@@ -177,32 +708,45 @@ static int process_code(FILE* h) {
 		case OP_JUMP: {
 			instruction_t* prev_instr;
 			instruction_t* next_instr;
+			jumptable_t* table;
 			if (index == 0)
 				break;
-			prev_instr = &instructions[index - 1];
+			// switch statement, list the target of each case
+			table = find_jumptable(index);
+			if (table) {
+				func = find_function(index);
+				out_printf(h, " ; switch %d..%d (table %x) >", table->first, table->first + table->count - 1, table->address);
+				for (int i = 0; i < table->count; i++) {
+					int target = jumptable_target(table, i);
+					out_printf(h, " %s+%d", function_name(func->start), target - func->start);
+				}
+				if (table->fallback >= 0)
+					out_printf(h, " default %s+%d", function_name(func->start), table->fallback - func->start);
+				semicolon = 1;
+				break;
+			}
+			prev_instr = get_instruction(index - 1);
 			if (prev_instr->opcode != OP_CONST)
 				break;
 			if (prev_instr->param >= instructioncount)
 				break;
 			symbol = find_code_symbol(prev_instr->param, -1);
 			if (symbol) {
-				fputs(" ;", h);
+				out_puts(h, " ;");
 				semicolon = 1;
 			}
 			else {
-				for (int i = prev_instr->param; i >= 0; i--) {
-					if (instructions[i].opcode == OP_ENTER) {
-						fprintf(h, " ; > func%d+%d", i, prev_instr->param - i);
-						semicolon = 1;
-						break;
-					}
+				func = find_function(prev_instr->param);
+				if (func) {
+					out_printf(h, " ; > func%d+%d", func->start, prev_instr->param - func->start);
+					semicolon = 1;
 				}
 			}
 			while (symbol) {
-				fprintf(h, " > %s+%d", symbol->symbol, prev_instr->param - symbol->offset);
-				next_instr = &instructions[prev_instr->param + 1];
+				out_printf(h, " > %s+%d", symbol->symbol, prev_instr->param - symbol->offset);
+				next_instr = get_instruction(prev_instr->param + 1);
 				if (next_instr->opcode == OP_LEAVE)
-					fputs(" (return)", h);
+					out_puts(h, " (return)");
 				symbol = find_code_symbol(prev_instr->param, symbol->index);
 			}
 			break;
@@ -228,23 +772,21 @@ static int process_code(FILE* h) {
 				break;
 			symbol = find_code_symbol(instr->param, -1);
 			if (symbol) {
-				fputs(" ;", h);
+				out_puts(h, " ;");
 				semicolon = 1;
 			}
 			else {
-				for (int i = instr->param; i >= 0; i--) {
-					if (instructions[i].opcode == OP_ENTER) {
-						fprintf(h, " ; > func%d+%d", i, instr->param - i);
-						semicolon = 1;
-						break;
-					}
+				func = find_function(instr->param);
+				if (func) {
+					out_printf(h, " ; > func%d+%d", func->start, instr->param - func->start);
+					semicolon = 1;
 				}
 			}
 			while (symbol) {
-				fprintf(h, " > %s+%d", symbol->symbol, instr->param - symbol->offset);
-				next_instr = &instructions[instr->param + 1];
+				out_printf(h, " > %s+%d", symbol->symbol, instr->param - symbol->offset);
+				next_instr = get_instruction(instr->param + 1);
 				if (next_instr->opcode == OP_LEAVE)
-					fputs(" (return)", h);
+					out_puts(h, " (return)");
 				symbol = find_code_symbol(instr->param, symbol->index);
 			}
 			break;
@@ -258,11 +800,11 @@ static int process_code(FILE* h) {
 				break;
 			if (index == instructioncount - 1)
 				break;
-			next_instr = &instructions[index + 1];
+			next_instr = get_instruction(index + 1);
 			if (next_instr->opcode == OP_LOAD1 ||
 				next_instr->opcode == OP_LOAD2 ||
 				next_instr->opcode == OP_LOAD4) {
-				fprintf(h, " ; (%x)", instr->param);
+				out_printf(h, " ; (%x)", instr->param);
 				semicolon = 1;
 				break;
 			}
@@ -271,11 +813,11 @@ static int process_code(FILE* h) {
 				break;
 			symbol = find_data_symbol(instr->param, -1);
 			if (symbol) {
-				fputs(" ;", h);
+				out_puts(h, " ;");
 				semicolon = 1;
 			}
 			while (symbol) {
-				fprintf(h, " %s+%d (?)", symbol->symbol, instr->param - symbol->offset);
+				out_printf(h, " %s+%d (?)", symbol->symbol, instr->param - symbol->offset);
 				symbol = find_data_symbol(instr->param, symbol->index);
 			}
 			break;
@@ -285,16 +827,16 @@ static int process_code(FILE* h) {
 		case OP_LOAD4: {
 			if (index == 0)
 				break;
-			instruction_t* prev_instr = &instructions[index - 1];
+			instruction_t* prev_instr = get_instruction(index - 1);
 			if (prev_instr->opcode != OP_CONST)
 				break;
 			symbol = find_data_symbol(prev_instr->param, -1);
 			if (symbol) {
-				fputs(" ;", h);
+				out_puts(h, " ;");
 				semicolon = 1;
 			}
 			while (symbol) {
-				fprintf(h, " %s+%d", symbol->symbol, prev_instr->param - symbol->offset);
+				out_printf(h, " %s+%d", symbol->symbol, prev_instr->param - symbol->offset);
 				symbol = find_data_symbol(prev_instr->param, symbol->index);
 			}
 			break;
@@ -306,19 +848,24 @@ static int process_code(FILE* h) {
 		// add line number if it exists
 		symbol = find_line(index, -1);
 		if (symbol && !semicolon)
-			fputs(" ;", h);
+			out_puts(h, " ;");
 		while (symbol) {
-			fprintf(h, " [%s]", symbol->symbol);
+			out_printf(h, " [%s]", symbol->symbol);
 			symbol = find_line(index, symbol->index);
 		}
 
-		fputs("\n", h);
-		fflush(h);
+		out_puts(h, "\n");
+		out_flush(h);
 	}
+
+	if (options.index)
+		index_end(h->pos);
+
+	return 1;
 }
 
 
-static void process_data(FILE* h) {
+static void process_data(output_t* h) {
 	if (symbolcount[SEGMENT_DATA] + symbolcount[SEGMENT_LIT] + symbolcount[SEGMENT_BSS] == 0)
 		return;
 
@@ -326,77 +873,415 @@ static void process_data(FILE* h) {
 }
 
 
-static void process_data_hex(FILE* h) {
+// output data segment hex view (data addresses start through end, exclusive)
+static void process_data_hex(output_t* h, int start, int end) {
 	uint8_t* p;
+	uint8_t* first = data + start;
+	uint8_t* last = data + end;
+
 	puts("Processing data segment hex view...");
-	fputs("\n\nDATA SEGMENT\n============\n", h);
-	fprintf(h, "LIT segment begins at offset %X (look for | in row %X)\n", datasize[SEGMENT_DATA], datasize[SEGMENT_DATA] & 0xFFFFFFE0);
+	out_puts(h, "\n\nDATA SEGMENT\n============\n");
+	out_printf(h, "LIT segment begins at offset %X (look for | in row %X)\n", datasize[SEGMENT_DATA], datasize[SEGMENT_DATA] & 0xFFFFFFE0);
+	if (start != 0 || end != datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT])
+		out_printf(h, "Showing offsets %X-%X\n", start, end - 1);
 
-	// start pointer at start of data segment
-	p = data;
+	// start pointer at start of the row containing the first byte
+	p = data + (start & ~(DATA_ROW_LEN - 1));
 
 	// loop through each byte in data segment
-	while (p < data + datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT]) {
+	while (p < last) {
 		// print offset
-		fprintf(h, "%04X ", p - data);
+		out_printf(h, "%04X ", (unsigned int)(p - data));
 
 		// print hex values
 		for (int b = 0; b < DATA_ROW_LEN; b++) {
 			// halfway through the row, print a gap
 			if (b == DATA_ROW_LEN / 2)
-				fputs("   ", h);
-			// if this row runs out of data before the end, print empty spaces
-			if (p + b >= data + datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT])
-				fputs("   ", h);
+				out_puts(h, "   ");
+			// if this row runs out of data before the end (or starts before the beginning), print empty spaces
+			if (p + b >= last || p + b < first)
+				out_puts(h, "   ");
 			// if this is the split between data and lit, put a bar
 			else if (p + b == data + datasize[SEGMENT_DATA])
-				fprintf(h, "|%02X", p[b]);
+				out_printf(h, "|%02X", p[b]);
 			else
-				fprintf(h, " %02X", p[b]);
+				out_printf(h, " %02X", p[b]);
 		}
 
-		fputs("    ", h);
+		out_puts(h, "    ");
 
 		// print characters
 		for (int b = 0; b < DATA_ROW_LEN; b++) {
 			// halfway through the row, print a gap
 			if (b == DATA_ROW_LEN / 2)
-				fprintf(h, " ");
-			// if this row runs out of data before the end, print empty spaces
-			if (p + b >= data + datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT])
-				fprintf(h, " ");
+				out_printf(h, " ");
+			// if this row runs out of data before the end (or starts before the beginning), print empty spaces
+			if (p + b >= last || p + b < first)
+				out_printf(h, " ");
 			else
-				fprintf(h, "%c", printablec(p[b]));
+				out_printf(h, "%c", printablec(p[b]));
 		}
 
-		fprintf(h, "\n");
-		fflush(h);
+		out_printf(h, "\n");
+		out_flush(h);
 
 		p += DATA_ROW_LEN;
 	}
 }
 
 
-static int process(const char* file) {
-	FILE* h;
+// parse an instruction index, or a code segment byte offset prefixed with '@'
+static int parse_code_location(const char* str, int* index) {
+	char* end;
+	long n;
 
-	h = fopen(file, "w");
-	if (!h || ferror(h)) {
-		fprintf(stderr, "File not found: %s\n", file);
-		goto fail;
+	if (*str == '@') {
+		n = strtol(str + 1, &end, 0);
+		if (end == str + 1 || n < 0 || n >= header.codelength)
+			return 0;
+		*index = find_instruction_by_offset((int)n);
+		return *index >= 0;
 	}
 
+	n = strtol(str, &end, 0);
+	if (end == str || n < 0 || n >= instructioncount)
+		return 0;
+	*index = (int)n;
+	return 1;
+}
+
+
+// determine instruction range from --func/--range options
+static int select_code(int* start, int* end) {
+	*start = 0;
+	*end = instructioncount;
+
+	if (options.func) {
+		symbolmap_t* symbol = find_symbol_by_name(options.func);
+		function_t* func;
+		if (!symbol || symbol->segment != SEGMENT_CODE || symbol->offset < 0) {
+			fprintf(stderr, "Function not found: %s\n", options.func);
+			return 0;
+		}
+		func = find_function(symbol->offset);
+		if (!func) {
+			fprintf(stderr, "Function not found: %s\n", options.func);
+			return 0;
+		}
+		*start = func->start;
+		*end = func->end;
+	}
+	else if (options.range) {
+		char buf[64];
+		char* sep;
+		int last;
+		strncpyz(buf, options.range, sizeof(buf));
+		sep = strchr(buf, ':');
+		if (!sep) {
+			fprintf(stderr, "Invalid range: %s\n", options.range);
+			return 0;
+		}
+		*sep = '\0';
+		if (!parse_code_location(buf, start) || !parse_code_location(sep + 1, &last) || last < *start) {
+			fprintf(stderr, "Invalid range: %s\n", options.range);
+			return 0;
+		}
+		*end = last + 1;
+	}
+
+	return 1;
+}
+
+
+// determine data address range from --data option
+static int select_data(int* start, int* end) {
+	symbolmap_t* symbol;
+
+	*start = 0;
+	*end = datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT];
+
+	if (!options.data)
+		return 1;
+
+	symbol = find_symbol_by_name(options.data);
+	if (!symbol || symbol->segment == SEGMENT_CODE) {
+		fprintf(stderr, "Data symbol not found: %s\n", options.data);
+		return 0;
+	}
+	if (symbol->segment == SEGMENT_BSS) {
+		fprintf(stderr, "Data symbol %s is in BSS and has no initialized data\n", options.data);
+		return 0;
+	}
+
+	*start = data_symbol_address(symbol);
+	*end = *start + data_symbol_size(symbol);
+	return 1;
+}
+
+
+// name of a file written alongside an output file ("file.qvm.txt.gz" -> "file.qvm" + ext)
+static void sidecar_name(char* name, size_t size, const char* file, const char* ext) {
+	char* p;
+	strncpyz(name, file, size);
+	if (options.gzip && (p = strrstr(name, ".gz")))
+		*p = '\0';
+	if ((p = strrstr(name, ".txt")))
+		*p = '\0';
+	strncatz(name, ext, size);
+}
+
+
+static int process(const char* file) {
+	output_t* h;
+	int code_start, code_end;
+	int data_start, data_end;
+	// when only some code or data is selected, skip the other
+	int want_code = options.func || options.range || !options.data;
+	int want_data = options.data || !(options.func || options.range);
+
+	if (!select_code(&code_start, &code_end) || !select_data(&data_start, &data_end))
+		return 0;
+
+	h = out_open(file, options.gzip);
+	if (!h)
+		return 0;
+
+	stats_begin(PHASE_PROCESS_HEADER);
 	process_header(h);
+	stats_end(PHASE_PROCESS_HEADER);
 
-	process_code(h);
+	if (want_code && options.types) {
+		puts("Processing operand stack...");
+		stats_begin(PHASE_OPSTACK);
+		find_opstack();
+		stats_end(PHASE_OPSTACK);
+	}
 
-	process_data(h);
+	if (want_code) {
+		puts("Processing code segment...");
+		stats_begin(PHASE_PROCESS_CODE);
+		process_code(h, code_start, code_end);
+		stats_end(PHASE_PROCESS_CODE);
+	}
 
-	process_data_hex(h);
+	if (options.cost) {
+		stats_begin(PHASE_REPORT_COST);
+		report_cost(h);
+		stats_end(PHASE_REPORT_COST);
+	}
+
+	if (options.traps) {
+		stats_begin(PHASE_REPORT_TRAPS);
+		report_traps(h);
+		stats_end(PHASE_REPORT_TRAPS);
+	}
+
+	if (options.stack) {
+		stats_begin(PHASE_REPORT_STACK);
+		report_stack(h);
+		stats_end(PHASE_REPORT_STACK);
+	}
+
+	if (options.globals) {
+		stats_begin(PHASE_REPORT_GLOBALS);
+		report_globals(h);
+		stats_end(PHASE_REPORT_GLOBALS);
+	}
+
+	if (options.bounds) {
+		stats_begin(PHASE_REPORT_BOUNDS);
+		report_bounds(h);
+		stats_end(PHASE_REPORT_BOUNDS);
+	}
+
+	if (options.effects) {
+		stats_begin(PHASE_REPORT_EFFECTS);
+		report_effects(h);
+		stats_end(PHASE_REPORT_EFFECTS);
+	}
+
+	if (options.size) {
+		stats_begin(PHASE_REPORT_SIZE);
+		report_size(h, options.sizesort);
+		stats_end(PHASE_REPORT_SIZE);
+	}
+
+	if (want_data) {
+		stats_begin(PHASE_PROCESS_DATA);
+		process_data(h);
+		stats_end(PHASE_PROCESS_DATA);
+
+		stats_begin(PHASE_PROCESS_DATA_HEX);
+		process_data_hex(h, data_start, data_end);
+		stats_end(PHASE_PROCESS_DATA_HEX);
+	}
+
+	if (!out_close(h)) {
+		fprintf(stderr, "Error writing %s\n", file);
+		return 0;
+	}
+
+	// positions in the index are into the uncompressed text, so it is named after that
+	if (options.index && want_code) {
+		char idxfile[1024];
+		char* p;
+		strncpyz(idxfile, file, sizeof(idxfile));
+		if (options.gzip && (p = strrstr(idxfile, ".gz")))
+			*p = '\0';
+		strncatz(idxfile, ".idx", sizeof(idxfile));
+		if (!index_write(idxfile))
+			return 0;
+	}
+
+	// "file.qvm.bounds", for a VM to load alongside the qvm
+	if (options.bounds) {
+		char boundsfile[1024];
+		sidecar_name(boundsfile, sizeof(boundsfile), file, ".bounds");
+		if (!write_bounds(boundsfile))
+			return 0;
+	}
+
+	// "file.qvm.types"
+	if (options.types && want_code) {
+		char typesfile[1024];
+		sidecar_name(typesfile, sizeof(typesfile), file, ".types");
+		if (!write_opstack(typesfile))
+			return 0;
+	}
 
 	return 1;
-fail:
-	if (h)
-		fclose(h);
+}
+
+
+// output header, each function, and the data segment to separate files in a directory
+// files whose content hash hasn't changed since the last call are left alone, and files for functions that no longer exist are removed
+static int process_split(const char* dir) {
+	char file[1024];
+	uint32_t symhash = watch_hash_symbols();
+	uint32_t* hashes;
+	uint32_t hash;
+	output_t* h;
+	int changed = 0;
+	int ret = 1;
+
+	strncpyz(file, dir, sizeof(file));
+	strncatz(file, "/header.txt", sizeof(file));
+	hash = fnv1a_buf(FNV1A_INIT, &header, sizeof(header));
+	if (watch_changed(file, hash)) {
+		h = out_open(file, COMPRESS_NONE);
+		if (!h)
+			return 0;
+		stats_begin(PHASE_PROCESS_HEADER);
+		process_header(h);
+		stats_end(PHASE_PROCESS_HEADER);
+		ret &= out_close(h);
+	}
+
+	if (options.types) {
+		puts("Processing operand stack...");
+		stats_begin(PHASE_OPSTACK);
+		find_opstack();
+		stats_end(PHASE_OPSTACK);
+	}
+
+	hashes = (uint32_t*)malloc((functioncount + 1) * sizeof(uint32_t));
+	if (!hashes || !watch_hash_functions(symhash, hashes)) {
+		fprintf(stderr, "Unable to allocate watch memory\n");
+		free(hashes);
+		return 0;
+	}
+
+	puts("Processing code segment...");
+	stats_begin(PHASE_PROCESS_CODE);
+	for (int f = 0; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		size_t len = strlen(dir) + 1;
+
+		// "00012_G_RunFrame.txt" sorts in code order
+		snprintf(file, sizeof(file), "%s/%05d_%s.txt", dir, f, function_name(func->start));
+		for (char* p = file + len; *p; p++) {
+			if (*p == '/' || *p == '\\' || *p == ':' || *p == '*' || *p == '?' || *p == '"' || *p == '<' || *p == '>' || *p == '|')
+				*p = '_';
+		}
+
+		if (!watch_changed(file, hashes[f]))
+			continue;
+		h = out_open(file, COMPRESS_NONE);
+		if (!h) {
+			ret = 0;
+			continue;
+		}
+		process_code(h, func->start, func->end);
+		ret &= out_close(h);
+		changed++;
+	}
+	stats_end(PHASE_PROCESS_CODE);
+	free(hashes);
+
+	strncpyz(file, dir, sizeof(file));
+	strncatz(file, "/data.txt", sizeof(file));
+	hash = fnv1a_buf(symhash, datasize, sizeof(datasize));
+	hash = fnv1a_buf(hash, data, datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT]);
+	if (watch_changed(file, hash)) {
+		h = out_open(file, COMPRESS_NONE);
+		if (!h)
+			return 0;
+		stats_begin(PHASE_PROCESS_DATA_HEX);
+		process_data_hex(h, 0, datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT]);
+		stats_end(PHASE_PROCESS_DATA_HEX);
+		ret &= out_close(h);
+	}
+
+	watch_sweep();
+
+	printf("%d of %d functions changed\n", changed, functioncount);
+	if (!ret)
+		fprintf(stderr, "Error writing files in %s\n", dir);
+	return ret;
+}
+
+
+// watch a qvm and its map file, and re-render the disassembly into "file.qvm.d/" whenever either changes
+// only runs until an error occurs watching the files
+static int process_watch(const char* qvmfile, const char* mapfile) {
+	char dir[1024];
+	const char* files[2];
+
+	strncpyz(dir, qvmfile, sizeof(dir));
+	strncatz(dir, ".d", sizeof(dir));
+	if (!make_dir(dir)) {
+		fprintf(stderr, "Unable to create directory %s\n", dir);
+		return 0;
+	}
+
+	files[0] = qvmfile;
+	files[1] = mapfile;
+	if (!watch_begin(files, 2))
+		return 0;
+
+	for (;;) {
+		int ret;
+
+		stats_begin(PHASE_PARSE_MAP);
+		parse_map(mapfile);
+		stats_end(PHASE_PARSE_MAP);
+
+		stats_begin(PHASE_PARSE_QVM);
+		ret = parse_qvm(qvmfile);
+		stats_end(PHASE_PARSE_QVM);
+
+		// a half-written qvm will be tried again on the next change
+		if (ret)
+			process_split(dir);
+		else
+			fprintf(stderr, "Failed to read QVM file %s\n", qvmfile);
+
+		printf("Watching %s and %s for changes...\n", qvmfile, mapfile);
+		fflush(stdout);
+		if (!watch_wait())
+			break;
+	}
+
+	watch_end();
 	return 0;
 }
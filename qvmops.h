@@ -24,4 +24,52 @@ Created By:
 // length in bytes of each row of the "hex editor" view of the data segment
 #define DATA_ROW_LEN	32
 
+// values for options.stats
+enum {
+	STATS_NONE,
+	STATS_TEXT,
+	STATS_JSON,
+};
+
+// command-line options
+typedef struct options_s {
+	int stats;				// report timing/counters at exit (STATS_*)
+	const char* statsfile;	// file to write json stats to, instead of stderr
+	const char* func;		// only disassemble this function
+	const char* range;		// only disassemble this instruction range ("start:end")
+	const char* data;		// only show hex view of this data symbol
+	int cost;				// output per-function cost and loop report
+	int traps;				// output trap call-site index and histogram
+	int stack;				// output worst-case call stack depth report
+	int globals;			// output unused/write-only globals report
+	int bounds;				// output bounds check report and .bounds table
+	int effects;			// output function side effect report
+	int size;				// output code size report
+	int sizesort;			// order of size tables (SIZE_SORT_*)
+	int types;				// output operand stack depth/type columns and .types table
+	int lazy;				// decode instructions on demand instead of all at once
+	int gzip;				// compress output files (COMPRESS_*)
+	int verify;				// only verify bytecode, don't write output
+	const char* verifylog;	// file to write verify diagnostics to, instead of stderr
+	int failfast;			// stop at the first input that fails
+	int strip;				// write a copy of the qvm with unreachable functions removed
+	int qvmd;				// write a pre-decoded .qvmd copy of the qvm
+	int reorder;			// write a copy of the qvm with functions reordered for call locality
+	const char* reorderprofile;	// "caller callee count" file to weight calls for reorder
+	int inlining;			// write a copy of the qvm with small leaf functions inlined
+	int inlinesize;			// largest function body to inline
+	int inlinegrowth;		// percent the code may grow by inlining
+	int mergelit;			// write a copy of the qvm with duplicate LIT strings merged
+	int ngrams;				// only count opcode sequences up to this length, reported across all inputs
+	int ngramweighted;		// weight opcode sequences by loop depth
+	int sizediff;			// only compare per-function code sizes of two inputs
+	int watch;				// keep re-rendering per-function output whenever the qvm or map changes
+	int index;				// write a binary .idx file of output positions alongside the disassembly
+	int jobs;				// number of worker processes for multiple inputs
+	const char* sigdbadd;	// add named functions to this signature database
+	const char* sigdbmatch;	// write a .map of functions matched from this signature database
+	const char* sigdbmodule;	// module system call names are added and matched under (default: qvm file name)
+} options_t;
+extern options_t options;
+
 #endif // QVMOPS_QVMOPS_H
@@ -0,0 +1,468 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "analysis.h"
+#include "cost.h"
+#include "rewrite.h"
+#include "reorder.h"
+
+int funcorder[MAX_FUNCTIONS];
+
+// an undirected call graph edge between two functions (a < b)
+typedef struct calledge_s {
+	int a;
+	int b;
+	int64_t weight;
+} calledge_t;
+
+static calledge_t* edges;
+static int edgecount;
+static int edgemax;
+
+// chains of functions being merged, by chain number
+typedef struct chain_s {
+	int* funcs;
+	int count;
+	int64_t weight;			// total weight of the edges merged into this chain
+} chain_t;
+
+static chain_t* chains;
+static int* chainof;		// chain number of each function
+static int* funcbytes;		// code size of each function
+
+
+static int add_edge(int f, int g, int64_t weight) {
+	if (f == g || weight <= 0)
+		return 1;
+	if (edgecount == edgemax) {
+		int newmax = edgemax ? edgemax * 2 : 1024;
+		calledge_t* newedges = (calledge_t*)realloc(edges, newmax * sizeof(calledge_t));
+		if (!newedges) {
+			fprintf(stderr, "Unable to allocate call graph memory\n");
+			return 0;
+		}
+		edges = newedges;
+		edgemax = newmax;
+	}
+	edges[edgecount].a = f < g ? f : g;
+	edges[edgecount].b = f < g ? g : f;
+	edges[edgecount].weight = weight;
+	edgecount++;
+	return 1;
+}
+
+
+// add an edge for every direct call, weighted by loop depth of the call site
+static int add_static_edges(void) {
+	find_loops();
+
+	for (int f = 0; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		for (int index = func->start; index + 1 < func->end; index++) {
+			function_t* callee;
+			int64_t weight = 1;
+			int depth;
+			if (instructions[index].opcode != OP_CONST || instructions[index + 1].opcode != OP_CALL || instructions[index].param < 0)
+				continue;
+			callee = find_function(instructions[index].param);
+			if (!callee || callee->start != instructions[index].param)
+				continue;
+			depth = loopdepth[index];
+			if (depth > MAX_LOOP_DEPTH)
+				depth = MAX_LOOP_DEPTH;
+			while (depth--)
+				weight *= LOOP_WEIGHT;
+			if (!add_edge(f, (int)(callee - functions), weight))
+				return 0;
+		}
+	}
+	return 1;
+}
+
+
+// function number from a symbol or "funcN" name, or -1
+static int find_function_by_name(const char* name) {
+	symbolmap_t* symbol = find_symbol_by_name(name);
+	function_t* func;
+	int index;
+
+	if (symbol && symbol->segment == SEGMENT_CODE)
+		index = symbol->offset;
+	else if (sscanf(name, "func%d", &index) != 1)
+		return -1;
+
+	if (index < 0 || index >= instructioncount)
+		return -1;
+	func = find_function(index);
+	if (!func || func->start != index)
+		return -1;
+	return (int)(func - functions);
+}
+
+
+// add an edge for every "caller callee count" line of a profile
+static int add_profile_edges(const char* profile) {
+	FILE* h;
+	char line[1024];
+	int linenum = 0;
+	int ok = 1;
+
+	h = fopen(profile, "r");
+	if (!h) {
+		fprintf(stderr, "File not found: %s\n", profile);
+		return 0;
+	}
+
+	while (fgets(line, sizeof(line), h)) {
+		char caller[256], callee[256];
+		long long count;
+		char* p = strchr(line, '#');
+		int f, g;
+
+		linenum++;
+		if (p)
+			*p = '\0';
+		for (p = line; isspace((unsigned char)*p); p++)
+			;
+		if (!*p)
+			continue;
+		if (sscanf(p, "%255s %255s %lld", caller, callee, &count) != 3) {
+			fprintf(stderr, "%s:%d: expected \"caller callee count\"\n", profile, linenum);
+			ok = 0;
+			break;
+		}
+		f = find_function_by_name(caller);
+		g = find_function_by_name(callee);
+		// profiles may come from other builds, so unknown functions are only skipped
+		if (f < 0 || g < 0) {
+			fprintf(stderr, "%s:%d: unknown function %s\n", profile, linenum, f < 0 ? caller : callee);
+			continue;
+		}
+		if (!add_edge(f, g, count)) {
+			ok = 0;
+			break;
+		}
+	}
+
+	fclose(h);
+	return ok;
+}
+
+
+static int compare_edge_funcs(const void* a, const void* b) {
+	const calledge_t* ea = (const calledge_t*)a;
+	const calledge_t* eb = (const calledge_t*)b;
+	if (ea->a != eb->a)
+		return ea->a < eb->a ? -1 : 1;
+	if (ea->b != eb->b)
+		return ea->b < eb->b ? -1 : 1;
+	return 0;
+}
+
+
+static int compare_edge_weight(const void* a, const void* b) {
+	const calledge_t* ea = (const calledge_t*)a;
+	const calledge_t* eb = (const calledge_t*)b;
+	if (ea->weight != eb->weight)
+		return ea->weight > eb->weight ? -1 : 1;
+	return compare_edge_funcs(a, b);
+}
+
+
+// byte range of a function within a chain (optionally reversed)
+static int chain_position(chain_t* chain, int f, int reversed, int* end) {
+	int pos = 0;
+	for (int i = 0; i < chain->count; i++) {
+		int g = chain->funcs[reversed ? chain->count - 1 - i : i];
+		if (g == f) {
+			*end = pos + funcbytes[g];
+			return pos;
+		}
+		pos += funcbytes[g];
+	}
+	*end = pos;
+	return pos;
+}
+
+
+static int chain_bytes(chain_t* chain) {
+	int bytes = 0;
+	for (int i = 0; i < chain->count; i++)
+		bytes += funcbytes[chain->funcs[i]];
+	return bytes;
+}
+
+
+// merge the chains of the two functions of an edge, in whichever of the orders that
+// keep vmMain first puts the two functions closest together
+static int merge_chains(calledge_t* edge) {
+	int ca = chainof[edge->a];
+	int cb = chainof[edge->b];
+	int best = -1;
+	int bestgap = 0;
+	int* funcs;
+	int count;
+
+	for (int option = 0; option < 8; option++) {
+		int swap = option & 1;
+		int revfirst = (option >> 1) & 1;
+		int revsecond = (option >> 2) & 1;
+		chain_t* first = &chains[swap ? cb : ca];
+		chain_t* second = &chains[swap ? ca : cb];
+		int ffirst = swap ? edge->b : edge->a;
+		int fsecond = swap ? edge->a : edge->b;
+		int start, end, gap;
+
+		// vmMain's chain must stay in front and forwards, and nothing may go before it
+		if ((chainof[0] == chainof[fsecond]) || (chainof[0] == chainof[ffirst] && revfirst))
+			continue;
+
+		chain_position(first, ffirst, revfirst, &end);
+		gap = chain_bytes(first) - end;
+		start = chain_position(second, fsecond, revsecond, &end);
+		gap += start;
+		if (best < 0 || gap < bestgap) {
+			best = option;
+			bestgap = gap;
+		}
+	}
+	if (best < 0)
+		return 1;
+
+	{
+		int swap = best & 1;
+		int revfirst = (best >> 1) & 1;
+		int revsecond = (best >> 2) & 1;
+		int cfirst = swap ? cb : ca;
+		int csecond = swap ? ca : cb;
+		chain_t* first = &chains[cfirst];
+		chain_t* second = &chains[csecond];
+
+		count = first->count + second->count;
+		funcs = (int*)malloc(count * sizeof(int));
+		if (!funcs) {
+			fprintf(stderr, "Unable to allocate call graph memory\n");
+			return 0;
+		}
+		for (int i = 0; i < first->count; i++)
+			funcs[i] = first->funcs[revfirst ? first->count - 1 - i : i];
+		for (int i = 0; i < second->count; i++)
+			funcs[first->count + i] = second->funcs[revsecond ? second->count - 1 - i : i];
+
+		// the merged chain takes the lower chain number, so vmMain's chain stays chain 0
+		if (csecond < cfirst) {
+			int t = cfirst;
+			cfirst = csecond;
+			csecond = t;
+		}
+		free(chains[cfirst].funcs);
+		free(chains[csecond].funcs);
+		chains[cfirst].funcs = funcs;
+		chains[cfirst].count = count;
+		chains[cfirst].weight += chains[csecond].weight + edge->weight;
+		chains[csecond].funcs = NULL;
+		chains[csecond].count = 0;
+		for (int i = 0; i < count; i++)
+			chainof[funcs[i]] = cfirst;
+	}
+	return 1;
+}
+
+
+static int compare_chains(const void* a, const void* b) {
+	const chain_t* ca = &chains[*(const int*)a];
+	const chain_t* cb = &chains[*(const int*)b];
+	if (ca->weight != cb->weight)
+		return ca->weight > cb->weight ? -1 : 1;
+	// chain numbers are the lowest original function number in the chain
+	return *(const int*)a < *(const int*)b ? -1 : 1;
+}
+
+
+static void free_order(void) {
+	if (chains) {
+		for (int c = 0; c < functioncount; c++)
+			free(chains[c].funcs);
+	}
+	free(chains);
+	free(chainof);
+	free(funcbytes);
+	free(edges);
+	chains = NULL;
+	chainof = NULL;
+	funcbytes = NULL;
+	edges = NULL;
+	edgecount = edgemax = 0;
+}
+
+
+// compute a function order that places callers near their most frequent callees (Pettis-Hansen chain merging)
+int find_function_order(const char* profile) {
+	int* order = NULL;
+	int ordercount = 0;
+	int merged = 0;
+	int ok = 0;
+
+	free_order();
+	for (int f = 0; f < functioncount; f++)
+		funcorder[f] = f;
+	if (!functioncount)
+		return 1;
+
+	chains = (chain_t*)calloc(functioncount, sizeof(chain_t));
+	chainof = (int*)malloc(functioncount * sizeof(int));
+	funcbytes = (int*)malloc(functioncount * sizeof(int));
+	order = (int*)malloc(functioncount * sizeof(int));
+	if (!chains || !chainof || !funcbytes || !order) {
+		fprintf(stderr, "Unable to allocate call graph memory\n");
+		goto done;
+	}
+
+	for (int f = 0; f < functioncount; f++) {
+		int end = functions[f].end < instructioncount ? instructions[functions[f].end].offset : header.codelength;
+		chains[f].funcs = (int*)malloc(sizeof(int));
+		if (!chains[f].funcs) {
+			fprintf(stderr, "Unable to allocate call graph memory\n");
+			goto done;
+		}
+		chains[f].funcs[0] = f;
+		chains[f].count = 1;
+		chainof[f] = f;
+		funcbytes[f] = end - instructions[functions[f].start].offset;
+	}
+
+	if (profile ? !add_profile_edges(profile) : !add_static_edges())
+		goto done;
+
+	// combine parallel edges, then merge the heaviest first
+	if (edgecount) {
+		int count = 0;
+		qsort(edges, edgecount, sizeof(calledge_t), compare_edge_funcs);
+		for (int i = 0; i < edgecount; i++) {
+			if (count && edges[count - 1].a == edges[i].a && edges[count - 1].b == edges[i].b)
+				edges[count - 1].weight += edges[i].weight;
+			else
+				edges[count++] = edges[i];
+		}
+		edgecount = count;
+		qsort(edges, edgecount, sizeof(calledge_t), compare_edge_weight);
+	}
+
+	for (int i = 0; i < edgecount; i++) {
+		if (chainof[edges[i].a] == chainof[edges[i].b])
+			continue;
+		if (!merge_chains(&edges[i]))
+			goto done;
+		merged++;
+	}
+
+	// vmMain's chain first, then the hottest chains, then the rest in their original order
+	for (int c = 1; c < functioncount; c++) {
+		if (chains[c].count)
+			order[ordercount++] = c;
+	}
+	qsort(order, ordercount, sizeof(int), compare_chains);
+
+	{
+		int pos = 0;
+		for (int i = 0; i < chains[0].count; i++)
+			funcorder[pos++] = chains[0].funcs[i];
+		for (int c = 0; c < ordercount; c++) {
+			chain_t* chain = &chains[order[c]];
+			for (int i = 0; i < chain->count; i++)
+				funcorder[pos++] = chain->funcs[i];
+		}
+	}
+
+	printf("Merged %d call edges into %d chains\n", merged, ordercount + 1);
+	ok = 1;
+
+done:
+	free(order);
+	if (!ok)
+		free_order();
+	return ok;
+}
+
+
+// sum of edge weight times distance between the starts of the two functions, with functions in a given order
+static int64_t weighted_distance(const int* order) {
+	int64_t total = 0;
+	int* start = (int*)malloc(functioncount * sizeof(int));
+	int pos = 0;
+
+	if (!start)
+		return 0;
+	for (int i = 0; i < functioncount; i++) {
+		start[order[i]] = pos;
+		pos += funcbytes[order[i]];
+	}
+	for (int i = 0; i < edgecount; i++) {
+		int distance = start[edges[i].a] - start[edges[i].b];
+		total += edges[i].weight * (distance < 0 ? -distance : distance);
+	}
+	free(start);
+	return total;
+}
+
+
+// write a copy of the loaded qvm (and map) with functions reordered
+int reorder_qvm(const char* qvmfile, const char* mapfile, const char* profile) {
+	int* original;
+	int64_t before, after;
+	int ok;
+
+	puts("Processing function order...");
+
+	if (!find_function_order(profile))
+		return 0;
+
+	original = (int*)malloc((functioncount + 1) * sizeof(int));
+	if (!original) {
+		fprintf(stderr, "Unable to allocate call graph memory\n");
+		free_order();
+		return 0;
+	}
+	for (int f = 0; f < functioncount; f++)
+		original[f] = f;
+	before = weighted_distance(original);
+	after = weighted_distance(funcorder);
+	free(original);
+
+	if (!rewrite_begin()) {
+		free_order();
+		return 0;
+	}
+
+	// anything before the first function (there shouldn't be anything) is kept
+	if (functioncount)
+		rewrite_copy(0, functions[0].start);
+	for (int f = 0; f < functioncount; f++)
+		rewrite_copy(functions[funcorder[f]].start, functions[funcorder[f]].end);
+
+	ok = rewrite_finish();
+	if (ok)
+		ok = write_qvm(qvmfile) && write_map(mapfile);
+
+	printf("Weighted call distance %lld -> %lld bytes\n", (long long)before, (long long)after);
+
+	rewrite_end();
+	free_order();
+	return ok;
+}
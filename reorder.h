@@ -0,0 +1,30 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_REORDER_H
+#define QVMOPS_REORDER_H
+
+#include <stdint.h>
+#include "qvm.h"
+
+// new position of each function (filled by find_function_order)
+extern int funcorder[MAX_FUNCTIONS];
+
+// compute a function order that places callers near their most frequent callees (Pettis-Hansen chain merging)
+// call edges are weighted by the static loop depth of each call site, or by a profile file of
+// "caller callee count" lines if one is given. vmMain is always kept first
+int find_function_order(const char* profile);
+
+// write a copy of the loaded qvm (and map) with functions reordered
+int reorder_qvm(const char* qvmfile, const char* mapfile, const char* profile);
+
+#endif // QVMOPS_REORDER_H
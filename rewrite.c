@@ -0,0 +1,387 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "analysis.h"
+#include "jumptable.h"
+#include "rewrite.h"
+
+instruction_t newcode[MAX_INSTRUCTIONS];
+int neworigin[MAX_INSTRUCTIONS];
+int newcount;
+int remap[MAX_INSTRUCTIONS];
+
+int ambiguousrefs;
+
+uint8_t* newdata;
+int newdatasize[SEGMENT_COUNT];
+int* litremap;
+
+
+// is this the first instruction of a function
+int is_function_start(int index) {
+	function_t* func = find_function(index);
+	return func && func->start == index;
+}
+
+
+// does this function contain a jump whose target is not a constant, and whose table couldn't be found
+static int has_computed_jump(function_t* func) {
+	for (int index = func->start + 1; index < func->end; index++) {
+		if (instructions[index].opcode == OP_JUMP && instructions[index - 1].opcode != OP_CONST && !find_jumptable(index))
+			return 1;
+	}
+	return 0;
+}
+
+
+// is this OP_CONST stored to a local that the same function later calls through
+// (LOCAL n; CONST f; STORE4 ... LOCAL n; LOAD4; CALL)
+static int calls_through_local(int index) {
+	function_t* func = find_function(index);
+	int slot;
+
+	if (!func || index < 1 || index + 1 >= func->end || instructions[index - 1].opcode != OP_LOCAL || instructions[index + 1].opcode != OP_STORE4)
+		return 0;
+	slot = instructions[index - 1].param;
+	for (int i = func->start; i + 2 < func->end; i++) {
+		if (instructions[i].opcode == OP_LOCAL && instructions[i].param == slot
+			&& instructions[i + 1].opcode == OP_LOAD4 && instructions[i + 2].opcode == OP_CALL)
+			return 1;
+	}
+	return 0;
+}
+
+
+// is this OP_CONST of a function start (other than vmMain, which is never moved), and how is it used
+// 0 if not, 1 if it is shown to flow into an OP_CALL, -1 if it may just be an integer
+// (passing, storing or returning a constant looks the same for a function pointer and a plain integer)
+static int const_function_ref(int index) {
+	instruction_t* instr = &instructions[index];
+
+	if (instr->opcode != OP_CONST || instr->param <= 0 || instr->param >= instructioncount || !is_function_start(instr->param))
+		return 0;
+	return calls_through_local(index) ? 1 : -1;
+}
+
+
+// does this instruction's param hold an instruction index
+// (branches, OP_CONST for OP_CALL/OP_JUMP, and OP_CONST of a function start stored to a local that is called through)
+int is_code_ref(int index) {
+	instruction_t* instr = &instructions[index];
+	int ref;
+
+	if (is_branch(instr->opcode))
+		return 1;
+	if (instr->opcode != OP_CONST || instr->param < 0 || instr->param >= instructioncount)
+		return 0;
+	if (index + 1 < instructioncount) {
+		vmop_t next = instructions[index + 1].opcode;
+		if (next == OP_CALL || next == OP_JUMP)
+			return 1;
+	}
+	ref = const_function_ref(index);
+	return ref > 0 || (ref < 0 && ambiguousrefs == AMBIGUOUS_POINTER);
+}
+
+
+// is this an OP_CONST of a function start that isn't used in a way that shows it's a function pointer
+int is_ambiguous_code_ref(int index) {
+	vmop_t next;
+
+	if (index + 1 < instructioncount) {
+		next = instructions[index + 1].opcode;
+		if (next == OP_CALL || next == OP_JUMP)
+			return 0;
+	}
+	return const_function_ref(index) < 0;
+}
+
+
+// does this data word hold an instruction index of any kind
+// 0 if not, 1 if it's in a recovered switch table, -1 if it may just be an integer
+static int data_function_ref(int address) {
+	int value;
+	function_t* func;
+
+	if (address < 0 || address + 4 > datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT])
+		return 0;
+	memcpy(&value, data + address, sizeof(int));
+	if (value <= 0 || value >= instructioncount)
+		return 0;
+
+	func = find_function(value);
+	if (!func)
+		return 0;
+	if (find_jumptable_by_address(address))
+		return 1;
+	// a function pointer, or an address in an unrecovered switch table
+	if (func->start != value && !has_computed_jump(func))
+		return 0;
+	return -1;
+}
+
+
+// does the data word at this (4-byte aligned) data address hold an instruction index
+int is_data_code_ref(int address) {
+	int ref = data_function_ref(address);
+	return ref > 0 || (ref < 0 && ambiguousrefs == AMBIGUOUS_POINTER);
+}
+
+
+// is this data word a function start or address in a function with an unrecovered computed jump,
+// outside any recovered switch table
+int is_ambiguous_data_code_ref(int address) {
+	return data_function_ref(address) < 0;
+}
+
+
+// list ambiguous values that the rewrite would change, returns how many
+static int report_ambiguous_refs(void) {
+	const char* treatment = ambiguousrefs == AMBIGUOUS_INT ? "left as an integer"
+		: ambiguousrefs == AMBIGUOUS_POINTER ? "re-pointed" : "may be a function pointer";
+	int count = 0;
+
+	for (int index = 0; index < instructioncount; index++) {
+		int value = instructions[index].param;
+		if (!is_ambiguous_code_ref(index) || remap[value] == value)
+			continue;
+		fprintf(stderr, "Instruction %d: OP_CONST %d (%s) %s\n", index, value, function_name(value), treatment);
+		count++;
+	}
+	for (int address = 0; address + 4 <= datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT]; address += 4) {
+		int value;
+		if (!is_ambiguous_data_code_ref(address))
+			continue;
+		memcpy(&value, data + address, sizeof(int));
+		if (remap[value] == value)
+			continue;
+		fprintf(stderr, "Data at 0x%X: %d (%s+%d) %s\n", address, value, function_name(find_function(value)->start),
+			value - find_function(value)->start, treatment);
+		count++;
+	}
+
+	return count;
+}
+
+
+// start a rewrite pass with an empty new code segment and a copy of the data segment
+int rewrite_begin(void) {
+	int size = datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT];
+
+	newcount = 0;
+	for (int i = 0; i < instructioncount; i++)
+		remap[i] = -1;
+
+	free(newdata);
+	free(litremap);
+	litremap = NULL;
+	newdata = (uint8_t*)malloc(size + 1);
+	if (!newdata) {
+		fprintf(stderr, "Unable to allocate data memory block: %d\n", size);
+		return 0;
+	}
+	memcpy(newdata, data, size);
+	memcpy(newdatasize, datasize, sizeof(newdatasize));
+
+	return 1;
+}
+
+
+// copy old instructions start through end (exclusive) to the end of the new code
+void rewrite_copy(int start, int end) {
+	for (int index = start; index < end && newcount < MAX_INSTRUCTIONS; index++) {
+		remap[index] = newcount;
+		neworigin[newcount] = index;
+		newcode[newcount] = instructions[index];
+		newcount++;
+	}
+}
+
+
+// add a new instruction whose param is already final
+void rewrite_emit(vmop_t op, int param) {
+	if (newcount >= MAX_INSTRUCTIONS)
+		return;
+	neworigin[newcount] = -1;
+	newcode[newcount].opcode = op;
+	newcode[newcount].param = param;
+	newcode[newcount].offset = 0;
+	newcount++;
+}
+
+
+// re-patch every code reference in copied instructions and data to new instruction indexes
+// returns 0 if a reference points at removed code
+int rewrite_finish(void) {
+	int ok = 1;
+	int offset = 0;
+	int ambiguous;
+
+	// values that may be function pointers or plain integers are never changed silently
+	ambiguous = report_ambiguous_refs();
+	if (ambiguous && ambiguousrefs == AMBIGUOUS_REFUSE) {
+		fprintf(stderr, "%d value(s) may or may not be function pointers, not writing (use --ambiguous int or --ambiguous pointer)\n", ambiguous);
+		return 0;
+	}
+
+	for (int i = 0; i < newcount; i++) {
+		int origin = neworigin[i];
+
+		// recalculate byte offsets
+		newcode[i].offset = offset;
+		offset += 1 + opcodeparamsize(newcode[i].opcode);
+
+		if (origin < 0 || !is_code_ref(origin))
+			continue;
+		if (newcode[i].param < 0 || newcode[i].param >= instructioncount || remap[newcode[i].param] < 0) {
+			fprintf(stderr, "Instruction %d refers to removed code at %d\n", origin, newcode[i].param);
+			ok = 0;
+			continue;
+		}
+		newcode[i].param = remap[newcode[i].param];
+	}
+
+	for (int address = 0; address + 4 <= datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT]; address += 4) {
+		int value;
+		if (!is_data_code_ref(address))
+			continue;
+		memcpy(&value, data + address, sizeof(int));
+		if (remap[value] < 0) {
+			fprintf(stderr, "Data at 0x%X refers to removed code at %d\n", address, value);
+			ok = 0;
+			continue;
+		}
+		value = remap[value];
+		memcpy(newdata + address, &value, sizeof(int));
+	}
+
+	return ok;
+}
+
+
+// free rewrite buffers
+void rewrite_end(void) {
+	free(newdata);
+	free(litremap);
+	newdata = NULL;
+	litremap = NULL;
+	newcount = 0;
+}
+
+
+// write the new code and data as a .qvm file
+int write_qvm(const char* file) {
+	FILE* h;
+	vmheader_t newheader;
+	uint8_t* code;
+	int codelen = 0;
+	int ok;
+
+	// instructions take at most 5 bytes each, plus padding
+	code = (uint8_t*)calloc(newcount * 5 + 4, 1);
+	if (!code) {
+		fprintf(stderr, "Unable to allocate code memory block\n");
+		return 0;
+	}
+	for (int i = 0; i < newcount; i++) {
+		int n = opcodeparamsize(newcode[i].opcode);
+		code[codelen++] = (uint8_t)newcode[i].opcode;
+		if (n == 1)
+			code[codelen] = (uint8_t)newcode[i].param;
+		else if (n == 4)
+			memcpy(code + codelen, &newcode[i].param, 4);
+		codelen += n;
+	}
+	// q3asm pads the code segment so the data segment is aligned
+	codelen = (codelen + 3) & ~3;
+
+	newheader.magic = VM_MAGIC;
+	newheader.opcount = newcount;
+	newheader.codeoffset = sizeof(vmheader_t);
+	newheader.codelength = codelen;
+	newheader.dataoffset = sizeof(vmheader_t) + codelen;
+	newheader.datalen = newdatasize[SEGMENT_DATA];
+	newheader.litlen = newdatasize[SEGMENT_LIT];
+	newheader.bsslen = newdatasize[SEGMENT_BSS];
+
+	printf("Writing %s...\n", file);
+
+	h = fopen(file, "wb");
+	if (!h) {
+		fprintf(stderr, "Unable to open %s for writing\n", file);
+		free(code);
+		return 0;
+	}
+
+	fwrite(&newheader, sizeof(newheader), 1, h);
+	fwrite(code, 1, codelen, h);
+	fwrite(newdata, 1, newheader.datalen + newheader.litlen, h);
+	ok = !ferror(h);
+	fclose(h);
+	free(code);
+
+	if (!ok)
+		fprintf(stderr, "Error writing %s\n", file);
+	return ok;
+}
+
+
+// write the loaded symbols as a .map file, with code symbols/lines moved according to remap (and LIT symbols according to litremap)
+int write_map(const char* file) {
+	FILE* h;
+	int ok;
+
+	if (!symbolcount[SEGMENT_CODE] && !symbolcount[SEGMENT_DATA] && !symbolcount[SEGMENT_LIT] && !symbolcount[SEGMENT_BSS])
+		return 1;
+
+	printf("Writing %s...\n", file);
+
+	h = fopen(file, "w");
+	if (!h) {
+		fprintf(stderr, "Unable to open %s for writing\n", file);
+		return 0;
+	}
+
+	for (int segment = 0; segment < SEGMENT_COUNT; segment++) {
+		for (int i = 0; i < symbolcount[segment]; i++) {
+			symbolmap_t* symbol = &symbols[segment][i];
+			int offset = symbol->offset;
+			// code symbols of removed functions are dropped, system calls are kept as-is
+			if (segment == SEGMENT_CODE && offset >= 0) {
+				if (offset >= instructioncount || remap[offset] < 0)
+					continue;
+				offset = remap[offset];
+			}
+			if (segment == SEGMENT_LIT && litremap && offset >= 0 && offset < datasize[SEGMENT_LIT])
+				offset = litremap[offset];
+			fprintf(h, "%d %8x %s\n", segment, (unsigned int)offset, symbol->symbol);
+		}
+	}
+
+	for (int i = 0; i < linecount; i++) {
+		if (lines[i].offset < 0 || lines[i].offset >= instructioncount || remap[lines[i].offset] < 0)
+			continue;
+		fprintf(h, "0 %8x %s\n", (unsigned int)remap[lines[i].offset], lines[i].symbol);
+	}
+
+	ok = !ferror(h);
+	fclose(h);
+
+	if (!ok)
+		fprintf(stderr, "Error writing %s\n", file);
+	return ok;
+}
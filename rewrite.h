@@ -0,0 +1,82 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_REWRITE_H
+#define QVMOPS_REWRITE_H
+
+#include <stdint.h>
+#include "qvm.h"
+
+// how values that may be function pointers or plain integers are treated (ambiguousrefs)
+enum {
+	AMBIGUOUS_REFUSE,		// list them and don't write anything if a rewrite would change them
+	AMBIGUOUS_INT,			// leave them alone
+	AMBIGUOUS_POINTER,		// re-point them
+};
+extern int ambiguousrefs;
+
+// code being built by a rewrite pass
+extern instruction_t newcode[MAX_INSTRUCTIONS];
+extern int neworigin[MAX_INSTRUCTIONS];		// old instruction index each new instruction was copied from, or -1
+extern int newcount;
+// old instruction index -> new instruction index, or -1 if removed
+extern int remap[MAX_INSTRUCTIONS];
+
+// data segment being built by a rewrite pass (DATA + LIT)
+extern uint8_t* newdata;
+extern int newdatasize[SEGMENT_COUNT];
+// old LIT offset -> new LIT offset, if the rewrite pass moved LIT data (otherwise NULL)
+extern int* litremap;
+
+// is this the first instruction of a function
+int is_function_start(int index);
+
+// does this instruction's param hold an instruction index
+// (branches, OP_CONST for OP_CALL/OP_JUMP, and OP_CONST of a function start stored to a local that is called through,
+// plus ambiguous ones when ambiguousrefs is AMBIGUOUS_POINTER)
+int is_code_ref(int index);
+
+// is this an OP_CONST of a function start that isn't used in a way that shows it's a function pointer
+int is_ambiguous_code_ref(int index);
+
+// does the data word at this (4-byte aligned) data address hold an instruction index
+// (recovered switch tables, plus function starts or addresses in functions with unrecovered computed jumps
+// when ambiguousrefs is AMBIGUOUS_POINTER)
+int is_data_code_ref(int address);
+
+// is this data word a function start or address in a function with an unrecovered computed jump,
+// outside any recovered switch table
+int is_ambiguous_data_code_ref(int address);
+
+// start a rewrite pass with an empty new code segment and a copy of the data segment
+int rewrite_begin(void);
+
+// copy old instructions start through end (exclusive) to the end of the new code
+void rewrite_copy(int start, int end);
+
+// add a new instruction whose param is already final
+void rewrite_emit(vmop_t op, int param);
+
+// re-patch every code reference in copied instructions and data to new instruction indexes
+// returns 0 if a reference points at removed code, or an ambiguous value would change and ambiguousrefs is AMBIGUOUS_REFUSE
+int rewrite_finish(void);
+
+// free rewrite buffers
+void rewrite_end(void);
+
+// write the new code and data as a .qvm file
+int write_qvm(const char* file);
+
+// write the loaded symbols as a .map file, with code symbols/lines moved according to remap (and LIT symbols according to litremap)
+int write_map(const char* file);
+
+#endif // QVMOPS_REWRITE_H
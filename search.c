@@ -0,0 +1,331 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "util.h"
+#include "search.h"
+
+#define SEARCH_WORDS	(MAX_PATTERN_ELEMS / 64)
+
+// a single instruction in a pattern
+typedef struct patternelem_s {
+	int opcode;				// -1 for any opcode
+	int hasparam;			// param must be between min and max
+	int min;
+	int max;
+	char* symbol;			// param must equal the address of this symbol (resolved for each qvm)
+	int pattern;			// index into patterns[]
+} patternelem_t;
+
+// a sequence of instructions to search for
+typedef struct pattern_s {
+	char* name;
+	int first;				// index into elems[] of first instruction
+	int len;
+} pattern_t;
+
+static pattern_t patterns[MAX_PATTERNS];
+int patterncount;
+static patternelem_t elems[MAX_PATTERN_ELEMS];
+static int elemcount;
+
+// search automaton: bit n of a mask is elems[n]
+static uint64_t opmask[OP_COUNT][SEARCH_WORDS];	// elements that accept each opcode
+static uint64_t startmask[SEARCH_WORDS];			// first element of each pattern
+static uint64_t finalmask[SEARCH_WORDS];			// last element of each pattern
+static uint64_t parammask[SEARCH_WORDS];			// elements with a param constraint
+static int compiled;
+
+
+// find an opcode by name, with or without "OP_"
+static int find_opcode(const char* name) {
+	char buf[32];
+
+	if (!strncmp(name, "OP_", 3) || !strncmp(name, "op_", 3))
+		name += 3;
+	for (int op = 0; op < OP_COUNT; op++) {
+		snprintf(buf, sizeof(buf), "%s", opcodename((vmop_t)op) + 3);
+		if (striequal(buf, name))
+			return op;
+	}
+	return -1;
+}
+
+
+// parse a param constraint: "*", "N", "N..M", or a symbol name
+static int parse_param(patternelem_t* elem, char* str) {
+	char* end;
+	char* dots;
+
+	if (!strcmp(str, "*"))
+		return 1;
+
+	elem->hasparam = 1;
+	if (isalpha((unsigned char)*str) || *str == '_') {
+		elem->symbol = strdup(str);
+		return elem->symbol != NULL;
+	}
+
+	dots = strstr(str, "..");
+	if (dots)
+		*dots = '\0';
+	elem->min = (int)strtol(str, &end, 0);
+	if (end == str || *end)
+		return 0;
+	elem->max = elem->min;
+	if (dots) {
+		elem->max = (int)strtol(dots + 2, &end, 0);
+		if (end == dots + 2 || *end || elem->max < elem->min)
+			return 0;
+	}
+	return 1;
+}
+
+
+// add a pattern, e.g. "name: CONST trap_Print; CALL" or "LOCAL 8..16; LOAD4; * ; STORE4"
+// returns 0 if it can't be parsed
+int search_add(const char* text) {
+	char buf[1024];
+	char* p = buf;
+	char* colon;
+	pattern_t* pattern;
+	int first = elemcount;
+
+	if (patterncount >= MAX_PATTERNS) {
+		fprintf(stderr, "Too many search patterns (max %d)\n", MAX_PATTERNS);
+		return 0;
+	}
+
+	strncpyz(buf, text, sizeof(buf));
+	pattern = &patterns[patterncount];
+	colon = strchr(buf, ':');
+	if (colon) {
+		*colon = '\0';
+		pattern->name = strdup(buf);
+		p = colon + 1;
+	}
+	else
+		pattern->name = strdup(text);
+
+	for (char* tok = strtok(p, ";"); tok; tok = strtok(NULL, ";")) {
+		char op[64] = "";
+		char param[256] = "";
+		patternelem_t* elem;
+		int n = sscanf(tok, " %63s %255s", op, param);
+
+		if (n < 1)
+			continue;
+		if (elemcount >= MAX_PATTERN_ELEMS) {
+			fprintf(stderr, "Search patterns too long (max %d instructions in total)\n", MAX_PATTERN_ELEMS);
+			goto fail;
+		}
+		elem = &elems[elemcount];
+		memset(elem, 0, sizeof(*elem));
+		elem->pattern = patterncount;
+		elem->opcode = strcmp(op, "*") ? find_opcode(op) : -1;
+		if (strcmp(op, "*") && elem->opcode < 0) {
+			fprintf(stderr, "Unknown opcode in search pattern: %s\n", op);
+			goto fail;
+		}
+		if (n > 1 && !parse_param(elem, param)) {
+			fprintf(stderr, "Invalid param in search pattern: %s\n", param);
+			goto fail;
+		}
+		elemcount++;
+	}
+
+	if (elemcount == first) {
+		fprintf(stderr, "Empty search pattern: %s\n", text);
+		goto fail;
+	}
+
+	pattern->first = first;
+	pattern->len = elemcount - first;
+	patterncount++;
+	compiled = 0;
+	return 1;
+
+fail:
+	while (elemcount > first)
+		free(elems[--elemcount].symbol);
+	free(pattern->name);
+	pattern->name = NULL;
+	return 0;
+}
+
+
+// add patterns from a file, one per line ('#' starts a comment)
+int search_load(const char* file) {
+	FILE* h;
+	char line[1024];
+	int ok = 1;
+
+	h = fopen(file, "r");
+	if (!h) {
+		fprintf(stderr, "File not found: %s\n", file);
+		return 0;
+	}
+
+	while (fgets(line, sizeof(line), h)) {
+		char* p = strchr(line, '#');
+		if (p)
+			*p = '\0';
+		line[strcspn(line, "\r\n")] = '\0';
+		for (p = line; isspace((unsigned char)*p); p++)
+			;
+		if (!*p)
+			continue;
+		if (!search_add(p)) {
+			ok = 0;
+			break;
+		}
+	}
+
+	fclose(h);
+	return ok;
+}
+
+
+// build the automaton masks from the pattern elements
+static void compile_patterns(void) {
+	memset(opmask, 0, sizeof(opmask));
+	memset(startmask, 0, sizeof(startmask));
+	memset(finalmask, 0, sizeof(finalmask));
+	memset(parammask, 0, sizeof(parammask));
+
+	for (int i = 0; i < elemcount; i++) {
+		uint64_t bit = (uint64_t)1 << (i % 64);
+		int w = i / 64;
+		for (int op = 0; op < OP_COUNT; op++) {
+			if (elems[i].opcode < 0 || elems[i].opcode == op)
+				opmask[op][w] |= bit;
+		}
+		if (elems[i].hasparam)
+			parammask[w] |= bit;
+	}
+	for (int p = 0; p < patterncount; p++) {
+		int first = patterns[p].first;
+		int last = first + patterns[p].len - 1;
+		startmask[first / 64] |= (uint64_t)1 << (first % 64);
+		finalmask[last / 64] |= (uint64_t)1 << (last % 64);
+	}
+
+	compiled = 1;
+}
+
+
+// resolve symbol params to this qvm's addresses
+static void resolve_symbols(void) {
+	for (int i = 0; i < elemcount; i++) {
+		symbolmap_t* symbol;
+		if (!elems[i].symbol)
+			continue;
+		symbol = find_symbol_by_name(elems[i].symbol);
+		// a missing symbol can't match anything
+		elems[i].min = 1;
+		elems[i].max = 0;
+		if (!symbol)
+			continue;
+		// code symbols are instruction indexes, and system calls are the negative OP_CONST that calls them
+		elems[i].min = elems[i].max = symbol->segment == SEGMENT_CODE ? symbol->offset : data_symbol_address(symbol);
+	}
+}
+
+
+// print a match of a pattern ending at an instruction
+static void report_match(const char* name, int elem, int index) {
+	pattern_t* pattern = &patterns[elems[elem].pattern];
+	int start = index - pattern->len + 1;
+	function_t* func = find_function(start);
+	symbolmap_t* line = NULL;
+
+	// nearest line record at or before the match, within the function
+	for (int i = start; func && i >= func->start && !line; i--)
+		line = find_line(i, -1);
+
+	if (func)
+		printf("%s: %06d @%07x %s+%d", name, start, instructions[start].offset, function_name(func->start), start - func->start);
+	else
+		printf("%s: %06d @%07x", name, start, instructions[start].offset);
+	if (line)
+		printf(" [%s]", line->symbol);
+	printf(": %s\n", pattern->name);
+}
+
+
+// search the currently loaded qvm for all patterns in a single pass, printing each match
+// returns the number of matches
+int search_qvm(const char* name) {
+	uint64_t state[SEARCH_WORDS] = { 0, };
+	int words = (elemcount + 63) / 64;
+	int matches = 0;
+
+	puts("Searching code segment...");
+
+	if (!compiled)
+		compile_patterns();
+	resolve_symbols();
+
+	for (int index = 0; index < instructioncount; index++) {
+		instruction_t* instr = &instructions[index];
+		uint64_t carry = 0;
+
+		// matches don't span functions, or invalid opcodes (which would index past opmask)
+		if (instr->opcode == OP_ENTER || (unsigned)instr->opcode >= OP_COUNT)
+			memset(state, 0, sizeof(state));
+		if ((unsigned)instr->opcode >= OP_COUNT)
+			continue;
+
+		// every partial match advances one element, and every pattern can start here
+		for (int w = 0; w < words; w++) {
+			uint64_t next = state[w] >> 63;
+			state[w] = ((state[w] << 1) | carry | startmask[w]) & opmask[instr->opcode][w];
+			carry = next;
+		}
+
+		// check params only for elements still alive
+		for (int w = 0; w < words; w++) {
+			uint64_t check = state[w] & parammask[w];
+			while (check) {
+				uint64_t bit = check & (~check + 1);
+				int i = w * 64;
+				for (uint64_t b = bit; b > 1; b >>= 1)
+					i++;
+				if (instr->param < elems[i].min || instr->param > elems[i].max)
+					state[w] &= ~bit;
+				check &= check - 1;
+			}
+		}
+
+		for (int w = 0; w < words; w++) {
+			uint64_t found = state[w] & finalmask[w];
+			while (found) {
+				uint64_t bit = found & (~found + 1);
+				int i = w * 64;
+				for (uint64_t b = bit; b > 1; b >>= 1)
+					i++;
+				report_match(name, i, index);
+				matches++;
+				found &= found - 1;
+			}
+		}
+	}
+
+	printf("%s: %d match(es)\n", name, matches);
+	return matches;
+}
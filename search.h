@@ -0,0 +1,34 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_SEARCH_H
+#define QVMOPS_SEARCH_H
+
+#define MAX_PATTERNS		256
+// total instructions in all patterns, each is a bit in the search automaton
+#define MAX_PATTERN_ELEMS	512
+
+// number of patterns added so far
+extern int patterncount;
+
+// add a pattern, e.g. "name: CONST trap_Print; CALL" or "LOCAL 8..16; LOAD4; * ; STORE4"
+// returns 0 if it can't be parsed
+int search_add(const char* text);
+
+// add patterns from a file, one per line ('#' starts a comment)
+int search_load(const char* file);
+
+// search the currently loaded qvm for all patterns in a single pass, printing each match
+// returns the number of matches
+int search_qvm(const char* name);
+
+#endif // QVMOPS_SEARCH_H
@@ -0,0 +1,652 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "analysis.h"
+#include "rewrite.h"
+#include "util.h"
+#include "sigdb.h"
+
+#define FNV64_INIT	14695981039346656037ull
+#define FNV64_PRIME	1099511628211ull
+
+// database in memory
+static char dbpath[1024];
+static sigentry_t* entries;
+static int entrycount;
+static int entryalloc;
+static char* strings;
+static int stringsize;
+static int stringalloc;
+
+// (exact hash, name) of every entry, to skip duplicates when adding
+static int* dupes;
+static int dupesize;
+
+// lookup tables for matching, rebuilt after entries are added
+typedef struct sigband_s {
+	uint64_t hash;
+	int entry;
+} sigband_t;
+static int* exactorder;
+static sigband_t* bands[SIG_BANDS];
+static int indexed;
+
+// signature of a function in the loaded qvm
+typedef struct sigmatch_s {
+	sigentry_t sig;
+	const char* name;		// name matched from the database
+	double score;			// 1 for an exact match, otherwise fraction of MinHash values that agree
+} sigmatch_t;
+
+
+static uint64_t fnv64(uint64_t hash, const void* buf, size_t len) {
+	const uint8_t* p = (const uint8_t*)buf;
+	while (len--)
+		hash = (hash ^ *p++) * FNV64_PRIME;
+	return hash;
+}
+
+
+// splitmix64 finalizer, to turn one shingle hash into many independent ones
+static uint64_t mix64(uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return x;
+}
+
+
+// the parts of an instruction that stay the same when the function is compiled into a different qvm:
+// code addresses within the function are made relative, system call numbers and frame offsets are kept,
+// and data addresses and calls to other functions are dropped
+static uint32_t instruction_token(const function_t* func, int index) {
+	instruction_t* instr = &instructions[index];
+	int param = 0;
+
+	switch (instr->opcode) {
+	case OP_ENTER:
+	case OP_LEAVE:
+	case OP_LOCAL:
+	case OP_ARG:
+	case OP_BLOCK_COPY:
+		param = instr->param;
+		break;
+	case OP_CONST:
+		if (instr->param < 0 && index + 1 < func->end && instructions[index + 1].opcode == OP_CALL)
+			param = instr->param;
+		else if (is_code_ref(index) && instr->param >= func->start && instr->param < func->end)
+			param = instr->param - func->start;
+		break;
+	default:
+		if (is_branch(instr->opcode))
+			param = instr->param - func->start;
+	}
+
+	return (uint32_t)instr->opcode | ((uint32_t)param << 8);
+}
+
+
+// build the signature of a function
+static void function_signature(const function_t* func, sigentry_t* sig) {
+	int len = func->end - func->start;
+	uint32_t* tokens = (uint32_t*)malloc(len * sizeof(uint32_t));
+
+	memset(sig, 0, sizeof(*sig));
+	sig->len = len;
+	sig->exact = FNV64_INIT;
+	for (int i = 0; i < SIG_MINHASHES; i++)
+		sig->minhash[i] = 0xFFFFFFFF;
+	if (!tokens)
+		return;
+
+	for (int i = 0; i < len; i++) {
+		tokens[i] = instruction_token(func, func->start + i);
+		sig->exact = fnv64(sig->exact, &tokens[i], sizeof(uint32_t));
+	}
+
+	// a function shorter than a shingle is one shingle
+	for (int i = 0; i == 0 || i + SIG_SHINGLE <= len; i++) {
+		int n = len < SIG_SHINGLE ? len : SIG_SHINGLE;
+		uint64_t shingle = fnv64(FNV64_INIT, tokens + i, n * sizeof(uint32_t));
+		for (int k = 0; k < SIG_MINHASHES; k++) {
+			uint32_t h = (uint32_t)(mix64(shingle + (uint64_t)(k + 1) * 0x9E3779B97F4A7C15ull) >> 32);
+			if (h < sig->minhash[k])
+				sig->minhash[k] = h;
+		}
+	}
+
+	free(tokens);
+}
+
+
+// key for a system call name: the module (case-insensitive) in the high half, the trap number in the low half
+static uint64_t trap_key(const char* module, int trap) {
+	uint32_t hash = FNV1A_INIT;
+	for (const char* p = module; *p; p++) {
+		uint8_t c = (uint8_t)tolower((uint8_t)*p);
+		hash = fnv1a_buf(hash, &c, 1);
+	}
+	return ((uint64_t)hash << 32) | (uint32_t)trap;
+}
+
+
+// name of the function starting at an instruction, if the map has one
+static const char* map_function_name(int index) {
+	symbolmap_t* symbol = find_code_symbol(index, -1);
+	return symbol && symbol->offset == index ? symbol->symbol : NULL;
+}
+
+
+static uint32_t dupe_hash(uint64_t exact, const char* name) {
+	return (uint32_t)(exact ^ (exact >> 32)) ^ fnv1a_buf(FNV1A_INIT, name, strlen(name));
+}
+
+
+// find an entry with the same hash and name, or the empty slot for it
+static int* find_dupe(uint64_t exact, const char* name) {
+	uint32_t slot = dupe_hash(exact, name) & (dupesize - 1);
+	while (dupes[slot]) {
+		sigentry_t* entry = &entries[dupes[slot] - 1];
+		if (entry->exact == exact && !strcmp(strings + entry->name, name))
+			return &dupes[slot];
+		slot = (slot + 1) & (dupesize - 1);
+	}
+	return &dupes[slot];
+}
+
+
+// rebuild the duplicate table at (at least) twice the number of entries
+static int grow_dupes(int count) {
+	int newsize = 1024;
+
+	while (newsize < count * 2)
+		newsize *= 2;
+	if (newsize <= dupesize)
+		return 1;
+
+	free(dupes);
+	dupes = (int*)calloc(newsize, sizeof(int));
+	if (!dupes) {
+		dupesize = 0;
+		return 0;
+	}
+	dupesize = newsize;
+	for (int i = 0; i < entrycount; i++)
+		*find_dupe(entries[i].exact, strings + entries[i].name) = i + 1;
+	return 1;
+}
+
+
+// add an entry unless it is already there, returns 1 if added
+static int add_entry(const sigentry_t* sig, const char* name) {
+	int* dupe;
+	int len = (int)strlen(name) + 1;
+
+	if (!grow_dupes(entrycount + 1))
+		return 0;
+	dupe = find_dupe(sig->exact, name);
+	if (*dupe)
+		return 0;
+
+	if (entrycount >= entryalloc) {
+		int newalloc = entryalloc ? entryalloc * 2 : 1024;
+		sigentry_t* grown = (sigentry_t*)realloc(entries, newalloc * sizeof(sigentry_t));
+		if (!grown)
+			return 0;
+		entries = grown;
+		entryalloc = newalloc;
+	}
+	if (stringsize + len > stringalloc) {
+		int newalloc = stringalloc ? stringalloc * 2 : 16384;
+		char* grown;
+		while (newalloc < stringsize + len)
+			newalloc *= 2;
+		grown = (char*)realloc(strings, newalloc);
+		if (!grown)
+			return 0;
+		strings = grown;
+		stringalloc = newalloc;
+	}
+
+	entries[entrycount] = *sig;
+	entries[entrycount].name = stringsize;
+	memcpy(strings + stringsize, name, len);
+	stringsize += len;
+	*dupe = ++entrycount;
+	indexed = 0;
+	return 1;
+}
+
+
+// load a database file into memory, if it isn't already (a missing file is an empty database)
+static int load_db(const char* dbfile) {
+	FILE* h;
+	sigdbheader_t dbheader;
+
+	if (!strcmp(dbpath, dbfile))
+		return 1;
+
+	free(entries);
+	free(strings);
+	free(dupes);
+	entries = NULL;
+	strings = NULL;
+	dupes = NULL;
+	entrycount = entryalloc = stringsize = stringalloc = dupesize = 0;
+	indexed = 0;
+	strncpyz(dbpath, dbfile, sizeof(dbpath));
+
+	h = fopen(dbfile, "rb");
+	if (!h)
+		return 1;
+
+	printf("Opening %s...\n", dbfile);
+
+	if (fread(&dbheader, sizeof(dbheader), 1, h) != 1 || dbheader.magic != SIGDB_MAGIC || dbheader.version != SIGDB_VERSION
+		|| dbheader.entrycount < 0 || dbheader.stringsize < 0) {
+		fprintf(stderr, "Invalid signature database: %s\n", dbfile);
+		goto fail;
+	}
+
+	entries = (sigentry_t*)malloc((dbheader.entrycount + 1) * sizeof(sigentry_t));
+	strings = (char*)malloc(dbheader.stringsize + 1);
+	if (!entries || !strings) {
+		fprintf(stderr, "Unable to allocate signature database memory\n");
+		goto fail;
+	}
+	if (fread(entries, sizeof(sigentry_t), dbheader.entrycount, h) != (size_t)dbheader.entrycount
+		|| fread(strings, 1, dbheader.stringsize, h) != (size_t)dbheader.stringsize) {
+		fprintf(stderr, "Invalid signature database: %s\n", dbfile);
+		goto fail;
+	}
+	// names must be inside the string table
+	strings[dbheader.stringsize] = '\0';
+	for (int i = 0; i < dbheader.entrycount; i++) {
+		if (entries[i].name < 0 || entries[i].name >= dbheader.stringsize) {
+			fprintf(stderr, "Invalid signature database: %s\n", dbfile);
+			goto fail;
+		}
+	}
+
+	entrycount = entryalloc = dbheader.entrycount;
+	stringsize = stringalloc = dbheader.stringsize;
+	fclose(h);
+	if (!grow_dupes(entrycount)) {
+		fprintf(stderr, "Unable to allocate signature database memory\n");
+		dbpath[0] = '\0';
+		return 0;
+	}
+	return 1;
+
+fail:
+	fclose(h);
+	free(entries);
+	free(strings);
+	entries = NULL;
+	strings = NULL;
+	dbpath[0] = '\0';
+	return 0;
+}
+
+
+// add the named functions and system calls of the loaded qvm to the database in memory
+// (loading it from file first, if it exists)
+int sigdb_add(const char* dbfile, const char* module) {
+	int added = 0;
+	int named = 0;
+
+	if (!load_db(dbfile))
+		return 0;
+
+	puts("Processing function signatures...");
+
+	for (int f = 0; f < functioncount; f++) {
+		sigentry_t sig;
+		const char* name = map_function_name(functions[f].start);
+		if (!name)
+			continue;
+		named++;
+		function_signature(&functions[f], &sig);
+		added += add_entry(&sig, name);
+	}
+
+	// system call numbers differ between games and between modules, so their names are kept for this module
+	for (int i = 0; i < symbolcount[SEGMENT_CODE]; i++) {
+		symbolmap_t* symbol = &symbols[SEGMENT_CODE][i];
+		sigentry_t sig;
+		if (symbol->offset >= 0)
+			continue;
+		memset(&sig, 0, sizeof(sig));
+		sig.exact = trap_key(module, -symbol->offset - 1);
+		sig.len = -1;
+		added += add_entry(&sig, symbol->symbol);
+	}
+
+	if (!named)
+		printf("No function names in map, nothing to add\n");
+	printf("Added %d new signature(s) (%d total), system calls as module %s\n", added, entrycount, module);
+	return 1;
+}
+
+
+// write the database in memory back to its file
+int sigdb_save(void) {
+	FILE* h;
+	sigdbheader_t dbheader;
+	int ok;
+
+	if (!dbpath[0])
+		return 1;
+
+	printf("Writing %s...\n", dbpath);
+
+	h = fopen(dbpath, "wb");
+	if (!h) {
+		fprintf(stderr, "Unable to open %s for writing\n", dbpath);
+		return 0;
+	}
+
+	dbheader.magic = SIGDB_MAGIC;
+	dbheader.version = SIGDB_VERSION;
+	dbheader.entrycount = entrycount;
+	dbheader.stringsize = stringsize;
+	fwrite(&dbheader, sizeof(dbheader), 1, h);
+	fwrite(entries, sizeof(sigentry_t), entrycount, h);
+	fwrite(strings, 1, stringsize, h);
+	ok = !ferror(h);
+	fclose(h);
+
+	if (!ok)
+		fprintf(stderr, "Error writing %s\n", dbpath);
+	return ok;
+}
+
+
+static uint64_t band_hash(const sigentry_t* sig, int band) {
+	return fnv64(FNV64_INIT + band, sig->minhash + band * SIG_ROWS, SIG_ROWS * sizeof(uint32_t));
+}
+
+
+static int compare_exact(const void* a, const void* b) {
+	const sigentry_t* ea = &entries[*(const int*)a];
+	const sigentry_t* eb = &entries[*(const int*)b];
+	if (ea->exact != eb->exact)
+		return ea->exact < eb->exact ? -1 : 1;
+	return *(const int*)a - *(const int*)b;
+}
+
+
+static int compare_band(const void* a, const void* b) {
+	const sigband_t* ba = (const sigband_t*)a;
+	const sigband_t* bb = (const sigband_t*)b;
+	if (ba->hash != bb->hash)
+		return ba->hash < bb->hash ? -1 : 1;
+	return ba->entry - bb->entry;
+}
+
+
+// sort entries by exact hash, and by the hash of each LSH band
+static int index_db(void) {
+	if (indexed)
+		return 1;
+
+	free(exactorder);
+	exactorder = (int*)malloc((entrycount + 1) * sizeof(int));
+	if (!exactorder)
+		return 0;
+	for (int i = 0; i < entrycount; i++)
+		exactorder[i] = i;
+	qsort(exactorder, entrycount, sizeof(int), compare_exact);
+
+	for (int b = 0; b < SIG_BANDS; b++) {
+		free(bands[b]);
+		bands[b] = (sigband_t*)malloc((entrycount + 1) * sizeof(sigband_t));
+		if (!bands[b])
+			return 0;
+		for (int i = 0; i < entrycount; i++) {
+			bands[b][i].hash = band_hash(&entries[i], b);
+			bands[b][i].entry = i;
+		}
+		qsort(bands[b], entrycount, sizeof(sigband_t), compare_band);
+	}
+
+	indexed = 1;
+	return 1;
+}
+
+
+// first position in exactorder with an exact hash not less than this one
+static int lower_exact(uint64_t exact) {
+	int lo = 0;
+	int hi = entrycount;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (entries[exactorder[mid]].exact < exact)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+
+// first position in a band with a hash not less than this one
+static int lower_band(const sigband_t* band, uint64_t hash) {
+	int lo = 0;
+	int hi = entrycount;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (band[mid].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+
+// find the name for an exact match, NULL if there is none or more than one name fits
+static const char* match_exact(uint64_t exact, int len) {
+	const char* name = NULL;
+
+	for (int i = lower_exact(exact); i < entrycount && entries[exactorder[i]].exact == exact; i++) {
+		sigentry_t* entry = &entries[exactorder[i]];
+		if (entry->len != len)
+			continue;
+		if (name && strcmp(name, strings + entry->name))
+			return NULL;
+		name = strings + entry->name;
+	}
+
+	return name;
+}
+
+
+// find the most similar function sharing at least one LSH band, NULL if none is similar enough or names tie
+static const char* match_fuzzy(const sigentry_t* sig, double* score) {
+	const char* best = NULL;
+	int bestequal = (int)(SIG_THRESHOLD * SIG_MINHASHES + 0.999);
+	int tie = 0;
+
+	for (int b = 0; b < SIG_BANDS; b++) {
+		uint64_t hash = band_hash(sig, b);
+		for (int i = lower_band(bands[b], hash); i < entrycount && bands[b][i].hash == hash; i++) {
+			sigentry_t* entry = &entries[bands[b][i].entry];
+			const char* name = strings + entry->name;
+			int equal = 0;
+
+			// very different lengths aren't the same function, whatever the shingles say
+			if (entry->len < SIG_MIN_FUZZY || entry->len > sig->len * 2 || sig->len > entry->len * 2)
+				continue;
+			for (int k = 0; k < SIG_MINHASHES; k++)
+				equal += entry->minhash[k] == sig->minhash[k];
+
+			if (equal > bestequal || (equal == bestequal && !best)) {
+				best = name;
+				bestequal = equal;
+				tie = 0;
+			}
+			else if (equal == bestequal && strcmp(best, name))
+				tie = 1;
+		}
+	}
+
+	if (!best || tie)
+		return NULL;
+	*score = (double)bestequal / SIG_MINHASHES;
+	return best;
+}
+
+
+// sort matches by score, best first
+static int compare_score(const void* a, const void* b) {
+	const sigmatch_t* ma = *(const sigmatch_t**)a;
+	const sigmatch_t* mb = *(const sigmatch_t**)b;
+	if (ma->score != mb->score)
+		return ma->score < mb->score ? 1 : -1;
+	return ma < mb ? -1 : ma > mb;
+}
+
+
+// is a name already given to a function (set if not)
+static int name_used(const char** used, int size, const char* name) {
+	uint32_t slot = fnv1a_buf(FNV1A_INIT, name, strlen(name)) & (size - 1);
+	while (used[slot]) {
+		if (!strcmp(used[slot], name))
+			return 1;
+		slot = (slot + 1) & (size - 1);
+	}
+	used[slot] = name;
+	return 0;
+}
+
+
+// match the functions of the loaded qvm against the database and write the names found as a .map file
+int sigdb_match(const char* dbfile, const char* mapfile, const char* module) {
+	sigmatch_t* matches;
+	sigmatch_t** sorted;
+	const char** used;
+	int usedsize = 1024;
+	int exact = 0;
+	int fuzzy = 0;
+	int traps = 0;
+	FILE* h;
+	int ok;
+
+	if (!load_db(dbfile))
+		return 0;
+	if (!entrycount) {
+		fprintf(stderr, "Signature database is empty: %s\n", dbfile);
+		return 0;
+	}
+
+	puts("Processing function signatures...");
+
+	// room for every function and system call name
+	while (usedsize < (functioncount + symbolcount[SEGMENT_CODE]) * 2)
+		usedsize *= 2;
+	matches = (sigmatch_t*)calloc(functioncount + 1, sizeof(sigmatch_t));
+	sorted = (sigmatch_t**)malloc((functioncount + 1) * sizeof(sigmatch_t*));
+	used = (const char**)calloc(usedsize, sizeof(const char*));
+	if (!matches || !sorted || !used || !index_db()) {
+		fprintf(stderr, "Unable to allocate signature matching memory\n");
+		ok = 0;
+		goto done;
+	}
+
+	for (int f = 0; f < functioncount; f++) {
+		sigmatch_t* match = &matches[f];
+		function_signature(&functions[f], &match->sig);
+		sorted[f] = match;
+
+		match->name = match_exact(match->sig.exact, match->sig.len);
+		if (match->name)
+			match->score = 1.0;
+		else if (match->sig.len >= SIG_MIN_FUZZY)
+			match->name = match_fuzzy(&match->sig, &match->score);
+	}
+	// vmMain is always first
+	if (functioncount && !matches[0].name) {
+		matches[0].name = "vmMain";
+		matches[0].score = 1.0;
+	}
+
+	// when two functions match the same name, the better match keeps it
+	qsort(sorted, functioncount, sizeof(sigmatch_t*), compare_score);
+	for (int i = 0; i < functioncount; i++) {
+		if (sorted[i]->name && name_used(used, usedsize, sorted[i]->name))
+			sorted[i]->name = NULL;
+	}
+
+	printf("Writing %s...\n", mapfile);
+
+	h = fopen(mapfile, "w");
+	if (!h) {
+		fprintf(stderr, "Unable to open %s for writing\n", mapfile);
+		ok = 0;
+		goto done;
+	}
+
+	for (int f = 0; f < functioncount; f++) {
+		if (!matches[f].name)
+			continue;
+		fprintf(h, "%d %8x %s\n", SEGMENT_CODE, (unsigned int)functions[f].start, matches[f].name);
+		if (matches[f].score >= 1.0)
+			exact++;
+		else
+			fuzzy++;
+	}
+
+	// names of the system calls this qvm makes
+	for (int index = 0; index + 1 < instructioncount; index++) {
+		const char* name = NULL;
+		uint64_t key;
+		if (instructions[index].opcode != OP_CONST || instructions[index].param >= 0 || instructions[index + 1].opcode != OP_CALL)
+			continue;
+		key = trap_key(module, -instructions[index].param - 1);
+		for (int i = lower_exact(key); i < entrycount && entries[exactorder[i]].exact == key; i++) {
+			sigentry_t* entry = &entries[exactorder[i]];
+			if (entry->len != -1)
+				continue;
+			if (name && strcmp(name, strings + entry->name)) {
+				name = NULL;
+				break;
+			}
+			name = strings + entry->name;
+		}
+		if (!name || name_used(used, usedsize, name))
+			continue;
+		fprintf(h, "%d %8x %s\n", SEGMENT_CODE, (unsigned int)instructions[index].param, name);
+		traps++;
+	}
+
+	ok = !ferror(h);
+	fclose(h);
+	if (!ok)
+		fprintf(stderr, "Error writing %s\n", mapfile);
+
+	printf("Matched %d of %d functions (%d exact, %d similar) and %d system call(s) of module %s\n", exact + fuzzy, functioncount, exact, fuzzy, traps, module);
+
+done:
+	free(matches);
+	free(sorted);
+	free(used);
+	return ok;
+}
@@ -0,0 +1,64 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_SIGDB_H
+#define QVMOPS_SIGDB_H
+
+#include <stdint.h>
+
+// magic number at start of signature database files ("QSDB")
+#define SIGDB_MAGIC		0x42445351
+#define SIGDB_VERSION	2
+
+// number of MinHash values per function, split into LSH bands
+#define SIG_MINHASHES	32
+#define SIG_BANDS		8
+#define SIG_ROWS		(SIG_MINHASHES / SIG_BANDS)
+// instructions per shingle
+#define SIG_SHINGLE		4
+// functions shorter than this are only matched exactly
+#define SIG_MIN_FUZZY	12
+// fraction of MinHash values that must agree for a fuzzy match
+#define SIG_THRESHOLD	0.7
+
+// signature database file layout (little endian):
+//   sigdbheader_t
+//   sigentry_t[entrycount]
+//   stringsize bytes of null-terminated names
+typedef struct sigdbheader_s {
+	uint32_t magic;
+	uint32_t version;
+	int32_t entrycount;
+	int32_t stringsize;
+} sigdbheader_t;
+
+// a named function (or system call) from a qvm with a map
+typedef struct sigentry_s {
+	uint64_t exact;						// hash of the normalized function, or module hash and trap number for system calls
+	uint32_t minhash[SIG_MINHASHES];	// MinHash of normalized instruction shingles
+	int32_t len;						// number of instructions, or -1 for a system call
+	int32_t name;						// offset of name in string table
+} sigentry_t;
+
+// add the named functions and system calls of the loaded qvm to the database in memory
+// (loading it from file first, if it exists)
+// module names the kind of qvm (qagame, cgame, ui), since each numbers its system calls differently
+int sigdb_add(const char* dbfile, const char* module);
+
+// write the database in memory back to its file
+int sigdb_save(void);
+
+// match the functions of the loaded qvm against the database and write the names found as a .map file
+// (system calls only match names added with the same module)
+int sigdb_match(const char* dbfile, const char* mapfile, const char* module);
+
+#endif // QVMOPS_SIGDB_H
@@ -0,0 +1,442 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "size.h"
+
+// code size of a function, source unit or source line
+typedef struct sizeentry_s {
+	int start;			// first instruction index (function start in the old build for removed functions)
+	int instrs;
+	int bytes;
+	int firstline;		// lowest and highest source line, 0 if none
+	int lastline;
+	int count;			// functions in a source unit, or function number of a source line
+	char* name;			// kept function name for diffs
+} sizeentry_t;
+
+// per-function sizes of one input, for diffs
+typedef struct sizeprofile_s {
+	char* name;
+	sizeentry_t* funcs;
+	int funccount;
+	int instrs;
+	int bytes;
+} sizeprofile_t;
+
+// a matched pair of functions for diffs (either may be missing)
+typedef struct sizediff_s {
+	sizeentry_t* old;
+	sizeentry_t* cur;
+} sizediff_t;
+
+static sizeentry_t* funcsizes;
+static sizeentry_t* unitsizes;
+static sizeentry_t* linesizes;
+static int unitcount;
+static int outsideinstrs;		// instructions before the first function
+static int outsidebytes;
+static int totalinstrs;
+static int totalbytes;
+static int sizesort;
+
+static sizeprofile_t profiles[2];
+static int profilecount;
+
+
+// parse a --size-sort key, returns -1 if unknown
+int parse_size_sort(const char* key) {
+	if (!strcmp(key, "bytes"))
+		return SIZE_SORT_BYTES;
+	if (!strcmp(key, "instructions"))
+		return SIZE_SORT_INSTRUCTIONS;
+	if (!strcmp(key, "name"))
+		return SIZE_SORT_NAME;
+	if (!strcmp(key, "address"))
+		return SIZE_SORT_ADDRESS;
+	return -1;
+}
+
+
+static void free_sizes(void) {
+	free(funcsizes);
+	free(unitsizes);
+	free(linesizes);
+	funcsizes = unitsizes = linesizes = NULL;
+	unitcount = 0;
+}
+
+
+// sort lines by instruction index
+static int compare_line_offset(const void* a, const void* b) {
+	const symbolmap_t* la = &lines[*(const int*)a];
+	const symbolmap_t* lb = &lines[*(const int*)b];
+	if (la->offset != lb->offset)
+		return la->offset - lb->offset;
+	return la->index - lb->index;
+}
+
+
+// count each function's and source line's instructions and bytes in a single pass over the code
+static int find_sizes(void) {
+	int* order;
+	int f = 0, l = 0, line = -1;
+	int lastline = 0;
+
+	free_sizes();
+	outsideinstrs = outsidebytes = totalinstrs = totalbytes = 0;
+
+	funcsizes = (sizeentry_t*)calloc(functioncount + 1, sizeof(sizeentry_t));
+	unitsizes = (sizeentry_t*)calloc(functioncount + 1, sizeof(sizeentry_t));
+	linesizes = (sizeentry_t*)calloc(linecount + 1, sizeof(sizeentry_t));
+	order = (int*)malloc((linecount + 1) * sizeof(int));
+	if (!funcsizes || !unitsizes || !linesizes || !order) {
+		fprintf(stderr, "Unable to allocate size report memory\n");
+		free(order);
+		free_sizes();
+		return 0;
+	}
+
+	// map lines aren't necessarily in code order
+	for (int i = 0; i < linecount; i++)
+		order[i] = i;
+	qsort(order, linecount, sizeof(int), compare_line_offset);
+
+	for (f = 0; f < functioncount; f++)
+		funcsizes[f].start = functions[f].start;
+	f = 0;
+
+	for (int index = 0; index < instructioncount; index++) {
+		int bytes = 1 + opcodeparamsize(instructions[index].opcode);
+		int number;
+
+		totalinstrs++;
+		totalbytes += bytes;
+
+		while (f < functioncount && functions[f].end <= index)
+			f++;
+		while (l < linecount && lines[order[l]].offset <= index)
+			line = order[l++];
+		if (f >= functioncount || functions[f].start > index) {
+			outsideinstrs++;
+			outsidebytes += bytes;
+			continue;
+		}
+		// a line doesn't carry over into the next function
+		if (line >= 0 && lines[line].offset < functions[f].start)
+			line = -1;
+
+		funcsizes[f].instrs++;
+		funcsizes[f].bytes += bytes;
+		if (line < 0)
+			continue;
+
+		if (!linesizes[line].instrs) {
+			linesizes[line].start = index;
+			linesizes[line].count = f;
+		}
+		linesizes[line].instrs++;
+		linesizes[line].bytes += bytes;
+
+		// "LINE n"
+		number = atoi(lines[line].symbol + 5);
+		linesizes[line].firstline = linesizes[line].lastline = number;
+		if (!funcsizes[f].firstline || number < funcsizes[f].firstline)
+			funcsizes[f].firstline = number;
+		if (number > funcsizes[f].lastline)
+			funcsizes[f].lastline = number;
+	}
+	free(order);
+
+	// the map doesn't name source files, but each file's functions come in line order, so a function
+	// starting above where the previous one ended starts a new file
+	for (f = 0; f < functioncount; f++) {
+		sizeentry_t* fs = &funcsizes[f];
+		sizeentry_t* unit = &unitsizes[unitcount - 1];
+
+		if (!unitcount || (fs->firstline && lastline && fs->firstline < lastline)) {
+			unit = &unitsizes[unitcount++];
+			unit->start = fs->start;
+			unit->count = 0;
+		}
+		unit->count++;
+		unit->instrs += fs->instrs;
+		unit->bytes += fs->bytes;
+		if (fs->firstline && (!unit->firstline || fs->firstline < unit->firstline))
+			unit->firstline = fs->firstline;
+		if (fs->lastline > unit->lastline)
+			unit->lastline = fs->lastline;
+		if (fs->lastline)
+			lastline = fs->lastline;
+	}
+
+	return 1;
+}
+
+
+// entries with no name are named by the function at their start
+static const char* entry_name(const sizeentry_t* e) {
+	return e->name ? e->name : function_name(e->start);
+}
+
+
+static int compare_size(const void* a, const void* b) {
+	const sizeentry_t* ea = (const sizeentry_t*)a;
+	const sizeentry_t* eb = (const sizeentry_t*)b;
+	int ret = 0;
+
+	switch (sizesort) {
+	case SIZE_SORT_BYTES:
+		ret = eb->bytes - ea->bytes;
+		break;
+	case SIZE_SORT_INSTRUCTIONS:
+		ret = eb->instrs - ea->instrs;
+		break;
+	case SIZE_SORT_NAME:
+		ret = strcmp(entry_name(ea), entry_name(eb));
+		break;
+	}
+	return ret ? ret : ea->start - eb->start;
+}
+
+
+static double percent(int part, int whole) {
+	return whole ? 100.0 * part / whole : 0.0;
+}
+
+
+// "first-last", or "-" if no lines
+static const char* line_range(const sizeentry_t* e, char* buf, size_t size) {
+	if (!e->firstline)
+		return "-";
+	snprintf(buf, size, "%d-%d", e->firstline, e->lastline);
+	return buf;
+}
+
+
+// output code bytes and instruction counts per function, per source unit and for the largest source lines
+void report_size(output_t* h, int sort) {
+	char range[32];
+	int* top;
+	int topcount = 0;
+
+	puts("Processing code size report...");
+
+	if (!find_sizes())
+		return;
+
+	sizesort = sort;
+	qsort(funcsizes, functioncount, sizeof(sizeentry_t), compare_size);
+	qsort(unitsizes, unitcount, sizeof(sizeentry_t), compare_size);
+
+	out_puts(h, "\n\nCODE SIZE\n=========\n");
+	out_printf(h, "Code segment: %d bytes, %d instructions in %d functions", totalbytes, totalinstrs, functioncount);
+	if (outsideinstrs)
+		out_printf(h, " (%d bytes, %d instructions outside any function)", outsidebytes, outsideinstrs);
+	out_puts(h, "\n");
+
+	out_puts(h, "\nBy function:\n");
+	out_printf(h, "%8s %6s %8s %11s  %s\n", "BYTES", "%", "INSTRS", "LINES", "FUNCTION");
+	for (int f = 0; f < functioncount; f++) {
+		sizeentry_t* fs = &funcsizes[f];
+		out_printf(h, "%8d %5.1f%% %8d %11s  %s\n", fs->bytes, percent(fs->bytes, totalbytes), fs->instrs,
+			line_range(fs, range, sizeof(range)), function_name(fs->start));
+	}
+
+	out_puts(h, "\nBy source unit (the map has no file names, so a unit starts wherever line numbers go back down):\n");
+	out_printf(h, "%8s %6s %8s %6s %11s  %s\n", "BYTES", "%", "INSTRS", "FUNCS", "LINES", "FIRST FUNCTION");
+	for (int u = 0; u < unitcount; u++) {
+		sizeentry_t* unit = &unitsizes[u];
+		out_printf(h, "%8d %5.1f%% %8d %6d %11s  %s\n", unit->bytes, percent(unit->bytes, totalbytes), unit->instrs,
+			unit->count, line_range(unit, range, sizeof(range)), function_name(unit->start));
+	}
+
+	// the largest lines, regardless of sort order
+	top = (int*)malloc((linecount + 1) * sizeof(int));
+	if (top) {
+		for (int i = 0; i < linecount; i++) {
+			if (linesizes[i].instrs)
+				top[topcount++] = i;
+		}
+		sizesort = SIZE_SORT_BYTES;
+		for (int i = 0; i < topcount && i < SIZE_TOP_LINES; i++) {
+			int best = i;
+			for (int j = i + 1; j < topcount; j++) {
+				if (compare_size(&linesizes[top[j]], &linesizes[top[best]]) < 0)
+					best = j;
+			}
+			int swap = top[i];
+			top[i] = top[best];
+			top[best] = swap;
+		}
+
+		out_printf(h, "\nLargest source lines (%d of %d):\n", topcount < SIZE_TOP_LINES ? topcount : SIZE_TOP_LINES, topcount);
+		out_printf(h, "%8s %6s %8s %8s  %s\n", "BYTES", "%", "INSTRS", "LINE", "FUNCTION");
+		for (int i = 0; i < topcount && i < SIZE_TOP_LINES; i++) {
+			sizeentry_t* ls = &linesizes[top[i]];
+			out_printf(h, "%8d %5.1f%% %8d %8d  %s\n", ls->bytes, percent(ls->bytes, totalbytes), ls->instrs,
+				ls->firstline, function_name(functions[ls->count].start));
+		}
+		free(top);
+	}
+
+	free_sizes();
+}
+
+
+// keep the loaded qvm's per-function sizes, to be compared by report_size_diff once all inputs are done
+void add_size_profile(const char* name) {
+	sizeprofile_t* profile;
+
+	puts("Processing code size profile...");
+
+	if (profilecount >= 2) {
+		// counted so report_size_diff can complain
+		profilecount++;
+		return;
+	}
+	if (!find_sizes())
+		return;
+
+	profile = &profiles[profilecount];
+	profile->name = strdup(name);
+	profile->funcs = (sizeentry_t*)calloc(functioncount + 1, sizeof(sizeentry_t));
+	if (!profile->name || !profile->funcs) {
+		fprintf(stderr, "Unable to allocate size report memory\n");
+		free(profile->name);
+		free(profile->funcs);
+		memset(profile, 0, sizeof(*profile));
+		free_sizes();
+		return;
+	}
+	for (int f = 0; f < functioncount; f++) {
+		profile->funcs[f] = funcsizes[f];
+		profile->funcs[f].name = strdup(function_name(functions[f].start));
+	}
+	profile->funccount = functioncount;
+	profile->instrs = totalinstrs;
+	profile->bytes = totalbytes;
+	profilecount++;
+
+	free_sizes();
+}
+
+
+static int compare_entry_name(const void* a, const void* b) {
+	return strcmp(entry_name((const sizeentry_t*)a), entry_name((const sizeentry_t*)b));
+}
+
+
+// sort by the size of the change, by name, or in new code order with removed functions last
+static int compare_diff(const void* a, const void* b) {
+	const sizediff_t* da = (const sizediff_t*)a;
+	const sizediff_t* db = (const sizediff_t*)b;
+	const sizeentry_t* na = da->cur ? da->cur : da->old;
+	const sizeentry_t* nb = db->cur ? db->cur : db->old;
+	int ret = 0;
+
+	switch (sizesort) {
+	case SIZE_SORT_BYTES:
+		ret = abs((db->cur ? db->cur->bytes : 0) - (db->old ? db->old->bytes : 0)) - abs((da->cur ? da->cur->bytes : 0) - (da->old ? da->old->bytes : 0));
+		break;
+	case SIZE_SORT_INSTRUCTIONS:
+		ret = abs((db->cur ? db->cur->instrs : 0) - (db->old ? db->old->instrs : 0)) - abs((da->cur ? da->cur->instrs : 0) - (da->old ? da->old->instrs : 0));
+		break;
+	case SIZE_SORT_ADDRESS:
+		if (!da->cur != !db->cur)
+			return da->cur ? -1 : 1;
+		ret = na->start - nb->start;
+		break;
+	}
+	return ret ? ret : strcmp(entry_name(na), entry_name(nb));
+}
+
+
+static void free_profiles(void) {
+	for (int p = 0; p < 2; p++) {
+		for (int f = 0; f < profiles[p].funccount; f++)
+			free(profiles[p].funcs[f].name);
+		free(profiles[p].funcs);
+		free(profiles[p].name);
+		memset(&profiles[p], 0, sizeof(profiles[p]));
+	}
+	profilecount = 0;
+}
+
+
+// output the per-function size changes between the first and second profiles kept, and free them
+int report_size_diff(FILE* h, int sort) {
+	sizeprofile_t* old = &profiles[0];
+	sizeprofile_t* cur = &profiles[1];
+	sizediff_t* diffs;
+	int diffcount = 0;
+	int added = 0, removed = 0, changed = 0;
+
+	if (profilecount != 2) {
+		fprintf(stderr, "--size-diff needs exactly two inputs (got %d)\n", profilecount);
+		free_profiles();
+		return 0;
+	}
+
+	diffs = (sizediff_t*)malloc((old->funccount + cur->funccount + 1) * sizeof(sizediff_t));
+	if (!diffs) {
+		fprintf(stderr, "Unable to allocate size report memory\n");
+		free_profiles();
+		return 0;
+	}
+
+	// match functions by name
+	qsort(old->funcs, old->funccount, sizeof(sizeentry_t), compare_entry_name);
+	qsort(cur->funcs, cur->funccount, sizeof(sizeentry_t), compare_entry_name);
+	for (int i = 0, j = 0; i < old->funccount || j < cur->funccount; ) {
+		int cmp = i >= old->funccount ? 1 : j >= cur->funccount ? -1 : strcmp(old->funcs[i].name, cur->funcs[j].name);
+		sizediff_t* d = &diffs[diffcount];
+		d->old = cmp <= 0 ? &old->funcs[i++] : NULL;
+		d->cur = cmp >= 0 ? &cur->funcs[j++] : NULL;
+		if (!d->old)
+			added++;
+		else if (!d->cur)
+			removed++;
+		else if (d->old->bytes == d->cur->bytes && d->old->instrs == d->cur->instrs)
+			continue;
+		else
+			changed++;
+		diffcount++;
+	}
+
+	sizesort = sort;
+	qsort(diffs, diffcount, sizeof(sizediff_t), compare_diff);
+
+	fputs("\nCODE SIZE DIFF\n==============\n", h);
+	fprintf(h, "%s -> %s\n", old->name, cur->name);
+	fprintf(h, "Code segment: %d -> %d bytes (%+d), %d -> %d instructions (%+d), %d -> %d functions\n",
+		old->bytes, cur->bytes, cur->bytes - old->bytes, old->instrs, cur->instrs, cur->instrs - old->instrs,
+		old->funccount, cur->funccount);
+	fprintf(h, "%d changed, %d added, %d removed (matched by name)\n", changed, added, removed);
+	fprintf(h, "%8s %9s %9s %8s  %s\n", "DELTA", "OLD", "NEW", "INSTRS", "FUNCTION");
+	for (int i = 0; i < diffcount; i++) {
+		sizediff_t* d = &diffs[i];
+		int oldbytes = d->old ? d->old->bytes : 0;
+		int newbytes = d->cur ? d->cur->bytes : 0;
+		int instrs = (d->cur ? d->cur->instrs : 0) - (d->old ? d->old->instrs : 0);
+		fprintf(h, "%+8d %9d %9d %+8d  %s%s\n", newbytes - oldbytes, oldbytes, newbytes, instrs,
+			d->cur ? d->cur->name : d->old->name, !d->old ? " [added]" : !d->cur ? " [removed]" : "");
+	}
+
+	free(diffs);
+	free_profiles();
+	return 1;
+}
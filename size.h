@@ -0,0 +1,43 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_SIZE_H
+#define QVMOPS_SIZE_H
+
+#include <stdio.h>
+#include "output.h"
+
+// how size tables are sorted
+typedef enum {
+	SIZE_SORT_BYTES,			// largest first
+	SIZE_SORT_INSTRUCTIONS,		// most instructions first
+	SIZE_SORT_NAME,
+	SIZE_SORT_ADDRESS,			// code order
+} sizesort_t;
+
+// number of source lines shown in report
+#define SIZE_TOP_LINES	25
+
+// parse a --size-sort key, returns -1 if unknown
+int parse_size_sort(const char* key);
+
+// output code bytes and instruction counts per function, per source unit and for the largest source lines
+void report_size(output_t* h, int sort);
+
+// keep the loaded qvm's per-function sizes, to be compared by report_size_diff once all inputs are done
+void add_size_profile(const char* name);
+
+// output the per-function size changes between the first and second profiles kept, and free them
+// returns 0 if there weren't exactly two
+int report_size_diff(FILE* h, int sort);
+
+#endif // QVMOPS_SIZE_H
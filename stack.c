@@ -0,0 +1,253 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "strip.h"
+#include "stack.h"
+
+int stackdepth[MAX_FUNCTIONS];
+int stacknext[MAX_FUNCTIONS];
+uint8_t recursive[MAX_FUNCTIONS];
+uint8_t indirectcall[MAX_FUNCTIONS];
+
+// call graph, as a list of callees for each function (edges[edgestart[f]] through edges[edgestart[f + 1]])
+static int* edgestart;
+static int* edges;
+
+
+// add each function's direct callees, and for calls through function pointers, every address-taken function
+static int build_call_graph(void) {
+	int* taken;
+	int takencount = 0;
+	int edgecount = 0;
+	int edgealloc = 1024;
+
+	find_address_taken();
+	taken = (int*)malloc((functioncount + 1) * sizeof(int));
+	edgestart = (int*)malloc((functioncount + 1) * sizeof(int));
+	edges = (int*)malloc(edgealloc * sizeof(int));
+	if (!taken || !edgestart || !edges)
+		goto fail;
+	for (int f = 0; f < functioncount; f++) {
+		if (addresstaken[f])
+			taken[takencount++] = f;
+	}
+
+	memset(indirectcall, 0, sizeof(indirectcall));
+	for (int f = 0; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		edgestart[f] = edgecount;
+
+		for (int index = func->start; index < func->end; index++) {
+			function_t* callee;
+			if (instructions[index].opcode != OP_CALL)
+				continue;
+			if (index == 0 || instructions[index - 1].opcode != OP_CONST) {
+				indirectcall[f] = 1;
+				continue;
+			}
+			// system calls don't use the program stack
+			callee = find_function(instructions[index - 1].param);
+			if (!callee)
+				continue;
+			if (edgecount + 1 > edgealloc) {
+				int* grown = (int*)realloc(edges, (edgealloc *= 2) * sizeof(int));
+				if (!grown)
+					goto fail;
+				edges = grown;
+			}
+			edges[edgecount++] = (int)(callee - functions);
+		}
+
+		if (indirectcall[f]) {
+			if (edgecount + takencount > edgealloc) {
+				int* grown;
+				while (edgecount + takencount > edgealloc)
+					edgealloc *= 2;
+				grown = (int*)realloc(edges, edgealloc * sizeof(int));
+				if (!grown)
+					goto fail;
+				edges = grown;
+			}
+			memcpy(edges + edgecount, taken, takencount * sizeof(int));
+			edgecount += takencount;
+		}
+	}
+	edgestart[functioncount] = edgecount;
+
+	free(taken);
+	return 1;
+
+fail:
+	fprintf(stderr, "Unable to allocate call graph memory\n");
+	free(taken);
+	free(edgestart);
+	free(edges);
+	edgestart = edges = NULL;
+	return 0;
+}
+
+
+// fill stackdepth, stacknext, recursive and indirectcall arrays
+// the depth of a function is its own frame plus the deepest of its callees; a call back into a function already
+// being walked (recursion) is flagged and not followed, since its depth has no static bound
+void find_stack_depth(void) {
+	uint8_t* state;		// 0 = not visited, 1 = on the walk stack, 2 = done
+	int* walk;			// function on each level of the walk
+	int* cursor;		// next edge to follow on each level
+	int top;
+
+	memset(stackdepth, 0, sizeof(stackdepth));
+	memset(recursive, 0, sizeof(recursive));
+	for (int f = 0; f < functioncount; f++)
+		stacknext[f] = -1;
+
+	if (!functioncount || !build_call_graph())
+		return;
+
+	state = (uint8_t*)calloc(functioncount, 1);
+	walk = (int*)malloc(functioncount * sizeof(int));
+	cursor = (int*)malloc(functioncount * sizeof(int));
+	if (!state || !walk || !cursor) {
+		fprintf(stderr, "Unable to allocate stack depth memory\n");
+		goto done;
+	}
+
+	// walk from vmMain first, then from anything not reached from it
+	for (int root = 0; root < functioncount; root++) {
+		if (state[root])
+			continue;
+		top = 0;
+		walk[0] = root;
+		cursor[0] = edgestart[root];
+		state[root] = 1;
+
+		while (top >= 0) {
+			int f = walk[top];
+
+			if (cursor[top] < edgestart[f + 1]) {
+				int callee = edges[cursor[top]++];
+				if (state[callee] == 0) {
+					walk[++top] = callee;
+					cursor[top] = edgestart[callee];
+					state[callee] = 1;
+				}
+				else if (state[callee] == 1) {
+					// every function on the walk from the callee back up to here is in the cycle
+					for (int i = top; i >= 0; i--) {
+						recursive[walk[i]] = 1;
+						if (walk[i] == callee)
+							break;
+					}
+				}
+				else if (stackdepth[callee] > stackdepth[f]) {
+					stackdepth[f] = stackdepth[callee];
+					stacknext[f] = callee;
+				}
+				continue;
+			}
+
+			// all callees done, stackdepth holds the deepest of them so far
+			stackdepth[f] += functions[f].framesize;
+			state[f] = 2;
+			top--;
+			if (top >= 0 && stackdepth[f] > stackdepth[walk[top]]) {
+				stackdepth[walk[top]] = stackdepth[f];
+				stacknext[walk[top]] = f;
+			}
+		}
+	}
+
+done:
+	free(state);
+	free(walk);
+	free(cursor);
+	free(edgestart);
+	free(edges);
+	edgestart = edges = NULL;
+}
+
+
+// sort by stack depth, deepest first
+static int compare_depth(const void* a, const void* b) {
+	int fa = *(const int*)a;
+	int fb = *(const int*)b;
+	if (stackdepth[fa] != stackdepth[fb])
+		return stackdepth[fa] < stackdepth[fb] ? 1 : -1;
+	return fa - fb;
+}
+
+
+// output worst-case stack depth, deepest call chain and per-function stack use
+void report_stack(output_t* h) {
+	symbolmap_t* stackstart = find_symbol_by_name("_stackStart");
+	symbolmap_t* stackend = find_symbol_by_name("_stackEnd");
+	int stacksize = PROGRAM_STACK_SIZE;
+	int worst;
+	int* sorted;
+	int anyrecursive = 0;
+	int anyindirect = 0;
+
+	puts("Processing stack depth report...");
+
+	find_stack_depth();
+
+	if (stackstart && stackend && stackend->offset > stackstart->offset)
+		stacksize = stackend->offset - stackstart->offset;
+	worst = functioncount ? VMMAIN_CALL_STACK + stackdepth[0] : 0;
+	for (int f = 0; f < functioncount; f++) {
+		anyrecursive |= recursive[f];
+		anyindirect |= indirectcall[f];
+	}
+
+	out_puts(h, "\n\nSTACK DEPTH\n===========\n");
+	out_printf(h, "Program stack: 0x%X (%d) bytes%s\n", stacksize, stacksize, stackstart && stackend ? " (_stackStart to _stackEnd)" : " (engine default)");
+	out_printf(h, "Worst case from vmMain: 0x%X (%d) bytes, %.1f%% of stack (including %d bytes for vmMain's arguments)\n",
+		worst, worst, stacksize ? 100.0 * worst / stacksize : 0.0, VMMAIN_CALL_STACK);
+	if (anyrecursive)
+		out_puts(h, "Recursive calls (R) are only counted once, so the real worst case depends on recursion depth\n");
+	if (anyindirect)
+		out_puts(h, "Calls through function pointers (I) are assumed to reach any function whose address is taken\n");
+	if (worst > stacksize)
+		out_puts(h, "WARNING: worst case is larger than the program stack\n");
+
+	if (!functioncount)
+		return;
+
+	out_puts(h, "\nDeepest call chain:\n");
+	out_printf(h, "%8s %8s %-5s %s\n", "FRAME", "DEPTH", "FLAGS", "FUNCTION");
+	for (int f = 0, depth = VMMAIN_CALL_STACK; f >= 0; f = stacknext[f]) {
+		depth += functions[f].framesize;
+		out_printf(h, "%8d %8d %c%c    %s\n", functions[f].framesize, depth, recursive[f] ? 'R' : ' ', indirectcall[f] ? 'I' : ' ', function_name(functions[f].start));
+	}
+
+	sorted = (int*)malloc(functioncount * sizeof(int));
+	if (!sorted) {
+		fprintf(stderr, "Unable to allocate stack report memory\n");
+		return;
+	}
+	for (int f = 0; f < functioncount; f++)
+		sorted[f] = f;
+	qsort(sorted, functioncount, sizeof(int), compare_depth);
+
+	out_printf(h, "\nDeepest functions (stack used by the function and everything it calls):\n");
+	out_printf(h, "%8s %8s %-5s %s\n", "FRAME", "DEPTH", "FLAGS", "FUNCTION");
+	for (int i = 0; i < functioncount && i < STACK_REPORT_TOP; i++) {
+		int f = sorted[i];
+		out_printf(h, "%8d %8d %c%c    %s\n", functions[f].framesize, stackdepth[f], recursive[f] ? 'R' : ' ', indirectcall[f] ? 'I' : ' ', function_name(functions[f].start));
+	}
+
+	free(sorted);
+}
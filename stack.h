@@ -0,0 +1,39 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_STACK_H
+#define QVMOPS_STACK_H
+
+#include "qvm.h"
+#include "output.h"
+
+// program stack the engine reserves for vmMain's arguments before calling it (8 + 4 * MAX_VMMAIN_ARGS in ioquake3)
+#define VMMAIN_CALL_STACK	60
+// number of functions listed in the per-function table of the report
+#define STACK_REPORT_TOP	50
+
+// worst-case program stack used by each function and everything it calls
+extern int stackdepth[MAX_FUNCTIONS];
+// callee on the deepest path from each function, or -1
+extern int stacknext[MAX_FUNCTIONS];
+// is each function part of a recursive cycle
+extern uint8_t recursive[MAX_FUNCTIONS];
+// does each function make a call through a function pointer
+extern uint8_t indirectcall[MAX_FUNCTIONS];
+
+// fill stackdepth, stacknext, recursive and indirectcall arrays
+void find_stack_depth(void);
+
+// output worst-case stack depth, deepest call chain and per-function stack use
+void report_stack(output_t* h);
+
+#endif // QVMOPS_STACK_H
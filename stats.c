@@ -0,0 +1,159 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+#include "stats.h"
+
+stats_t stats;
+
+// start times of phases currently in progress
+static double wall_start[PHASE_COUNT];
+static double cpu_start[PHASE_COUNT];
+
+static const char* phasenames[PHASE_COUNT] = {
+	"parse_map",
+	"parse_qvm",
+	"process_header",
+	"opstack",
+	"process_code",
+	"process_data",
+	"process_data_hex",
+	"report_cost",
+	"report_traps",
+	"report_stack",
+	"report_globals",
+	"report_bounds",
+	"report_effects",
+	"report_size",
+	"verify",
+	"ngrams",
+	"search",
+};
+
+
+// current wall clock time in seconds
+static double wall_time(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+// cpu time used by this process in seconds
+static double cpu_time(void) {
+#ifdef _WIN32
+	FILETIME create, exit, kernel, user;
+	ULARGE_INTEGER k, u;
+	if (!GetProcessTimes(GetCurrentProcess(), &create, &exit, &kernel, &user))
+		return 0.0;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	// FILETIME is in 100ns units
+	return (k.QuadPart + u.QuadPart) / 1e7;
+#else
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru))
+		return 0.0;
+	return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+#endif
+}
+
+
+void stats_begin(statphase_t phase) {
+	wall_start[phase] = wall_time();
+	cpu_start[phase] = cpu_time();
+}
+
+
+void stats_end(statphase_t phase) {
+	stats.wall[phase] += wall_time() - wall_start[phase];
+	stats.cpu[phase] += cpu_time() - cpu_start[phase];
+	stats.calls[phase]++;
+}
+
+
+// peak resident set size of the process in bytes (0 if unknown)
+int64_t stats_peak_rss(void) {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return (int64_t)pmc.PeakWorkingSetSize;
+#else
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru))
+		return 0;
+#ifdef __APPLE__
+	// bytes on macOS
+	return (int64_t)ru.ru_maxrss;
+#else
+	// kilobytes on Linux/BSD
+	return (int64_t)ru.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+
+// average number of entries scanned per lookup
+static double average_scan(int64_t scans, int64_t lookups) {
+	return lookups ? (double)scans / lookups : 0.0;
+}
+
+
+// output collected stats as text or json
+void stats_report(FILE* h, int json) {
+	int64_t rss = stats_peak_rss();
+
+	if (json) {
+		fputs("{\n  \"phases\": {\n", h);
+		for (int i = 0; i < PHASE_COUNT; i++) {
+			fprintf(h, "    \"%s\": { \"calls\": %d, \"wall\": %.6f, \"cpu\": %.6f }%s\n", phasenames[i], stats.calls[i], stats.wall[i], stats.cpu[i], i < PHASE_COUNT - 1 ? "," : "");
+		}
+		fputs("  },\n", h);
+		fprintf(h, "  \"instructions_decoded\": %lld,\n", (long long)stats.instructions_decoded);
+		fprintf(h, "  \"symbol_lookups\": %lld,\n", (long long)stats.symbol_lookups);
+		fprintf(h, "  \"symbol_scan_avg\": %.2f,\n", average_scan(stats.symbol_scans, stats.symbol_lookups));
+		fprintf(h, "  \"line_lookups\": %lld,\n", (long long)stats.line_lookups);
+		fprintf(h, "  \"line_scan_avg\": %.2f,\n", average_scan(stats.line_scans, stats.line_lookups));
+		fprintf(h, "  \"bytes_written\": %lld,\n", (long long)stats.bytes_written);
+		fprintf(h, "  \"write_calls\": %lld,\n", (long long)stats.write_calls);
+		fprintf(h, "  \"flush_calls\": %lld,\n", (long long)stats.flush_calls);
+		fprintf(h, "  \"peak_rss\": %lld\n", (long long)rss);
+		fputs("}\n", h);
+		return;
+	}
+
+	fputs("\nSTATS\n=====\n", h);
+	fprintf(h, "%-18s %6s %12s %12s\n", "PHASE", "CALLS", "WALL(s)", "CPU(s)");
+	for (int i = 0; i < PHASE_COUNT; i++) {
+		if (!stats.calls[i])
+			continue;
+		fprintf(h, "%-18s %6d %12.6f %12.6f\n", phasenames[i], stats.calls[i], stats.wall[i], stats.cpu[i]);
+	}
+	fprintf(h, "Instructions decoded: %lld\n", (long long)stats.instructions_decoded);
+	fprintf(h, "Symbol lookups: %lld (avg scan %.2f)\n", (long long)stats.symbol_lookups, average_scan(stats.symbol_scans, stats.symbol_lookups));
+	fprintf(h, "Line lookups: %lld (avg scan %.2f)\n", (long long)stats.line_lookups, average_scan(stats.line_scans, stats.line_lookups));
+	fprintf(h, "Bytes written: %lld\n", (long long)stats.bytes_written);
+	fprintf(h, "Write calls: %lld (%lld flushes)\n", (long long)stats.write_calls, (long long)stats.flush_calls);
+	fprintf(h, "Peak RSS: %lld KB\n", (long long)(rss / 1024));
+}
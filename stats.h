@@ -0,0 +1,68 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_STATS_H
+#define QVMOPS_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// timed phases
+typedef enum statphase_e {
+	PHASE_PARSE_MAP,
+	PHASE_PARSE_QVM,
+	PHASE_PROCESS_HEADER,
+	PHASE_OPSTACK,
+	PHASE_PROCESS_CODE,
+	PHASE_PROCESS_DATA,
+	PHASE_PROCESS_DATA_HEX,
+	PHASE_REPORT_COST,
+	PHASE_REPORT_TRAPS,
+	PHASE_REPORT_STACK,
+	PHASE_REPORT_GLOBALS,
+	PHASE_REPORT_BOUNDS,
+	PHASE_REPORT_EFFECTS,
+	PHASE_REPORT_SIZE,
+	PHASE_VERIFY,
+	PHASE_NGRAMS,
+	PHASE_SEARCH,
+	PHASE_COUNT
+} statphase_t;
+
+// timing and counters collected during a run
+typedef struct stats_s {
+	double wall[PHASE_COUNT];		// wall clock seconds spent in each phase
+	double cpu[PHASE_COUNT];		// cpu seconds spent in each phase
+	int calls[PHASE_COUNT];			// number of times each phase was entered
+
+	int64_t instructions_decoded;
+	int64_t symbol_lookups;			// calls to find_code_symbol/find_data_symbol
+	int64_t symbol_scans;			// symbols examined by those calls
+	int64_t line_lookups;			// calls to find_line
+	int64_t line_scans;				// lines examined by those calls
+	int64_t bytes_written;
+	int64_t write_calls;
+	int64_t flush_calls;
+} stats_t;
+extern stats_t stats;
+
+// mark the start/end of a timed phase
+void stats_begin(statphase_t phase);
+void stats_end(statphase_t phase);
+
+// peak resident set size of the process in bytes (0 if unknown)
+int64_t stats_peak_rss(void);
+
+// output collected stats as text or json
+void stats_report(FILE* h, int json);
+
+#endif // QVMOPS_STATS_H
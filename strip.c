@@ -0,0 +1,145 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "rewrite.h"
+#include "strip.h"
+
+uint8_t reachable[MAX_FUNCTIONS];
+uint8_t addresstaken[MAX_FUNCTIONS];
+
+
+// mark a function reachable and add it to the worklist
+static void mark_function(int index, int* worklist, int* count) {
+	function_t* func = find_function(index);
+	int f;
+
+	if (!func)
+		return;
+	f = (int)(func - functions);
+	if (reachable[f])
+		return;
+	reachable[f] = 1;
+	worklist[(*count)++] = f;
+}
+
+
+// mark functions whose address is used other than to call them directly, by code (OP_CONST) or data (function pointers)
+void find_address_taken(void) {
+	memset(addresstaken, 0, sizeof(addresstaken));
+
+	for (int index = 0; index + 1 < instructioncount; index++) {
+		function_t* func;
+		if (instructions[index].opcode != OP_CONST || instructions[index + 1].opcode == OP_CALL)
+			continue;
+		// a value that may be a function pointer keeps its function unless told it's an integer
+		if (!is_code_ref(index) && !(is_ambiguous_code_ref(index) && ambiguousrefs != AMBIGUOUS_INT))
+			continue;
+		if (!is_function_start(instructions[index].param))
+			continue;
+		func = find_function(instructions[index].param);
+		addresstaken[func - functions] = 1;
+	}
+	for (int address = 0; address + 4 <= datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT]; address += 4) {
+		int value;
+		memcpy(&value, data + address, sizeof(int));
+		if ((is_data_code_ref(address) || (is_ambiguous_data_code_ref(address) && ambiguousrefs != AMBIGUOUS_INT)) && is_function_start(value))
+			addresstaken[find_function(value) - functions] = 1;
+	}
+}
+
+
+// mark functions reachable from vmMain through direct calls, and from any function whose address is taken
+void find_reachable(void) {
+	int* worklist;
+	int count = 0;
+
+	memset(reachable, 0, sizeof(reachable));
+	if (!functioncount)
+		return;
+
+	worklist = (int*)malloc(functioncount * sizeof(int));
+	if (!worklist) {
+		// can't tell, so keep everything
+		memset(reachable, 1, functioncount);
+		return;
+	}
+
+	// vmMain is always the first function
+	mark_function(0, worklist, &count);
+
+	// function pointers may be called from anywhere
+	find_address_taken();
+	for (int f = 0; f < functioncount; f++) {
+		if (addresstaken[f])
+			mark_function(functions[f].start, worklist, &count);
+	}
+
+	// follow direct calls
+	while (count) {
+		function_t* func = &functions[worklist[--count]];
+		for (int index = func->start; index + 1 < func->end; index++) {
+			if (instructions[index].opcode == OP_CONST && instructions[index + 1].opcode == OP_CALL && instructions[index].param >= 0)
+				mark_function(instructions[index].param, worklist, &count);
+		}
+	}
+
+	free(worklist);
+}
+
+
+// write a copy of the loaded qvm (and map) with unreachable functions removed
+int strip_qvm(const char* qvmfile, const char* mapfile) {
+	int removed = 0;
+	int removedinstr = 0;
+	int oldlen = header.codelength;
+	int newlen;
+	int ok;
+
+	puts("Processing dead functions...");
+
+	find_reachable();
+
+	if (!rewrite_begin())
+		return 0;
+
+	// anything before the first function (there shouldn't be anything) is kept
+	if (functioncount)
+		rewrite_copy(0, functions[0].start);
+
+	for (int f = 0; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		if (reachable[f]) {
+			rewrite_copy(func->start, func->end);
+			continue;
+		}
+		printf("Removing %s (%d instructions)\n", function_name(func->start), func->end - func->start);
+		removed++;
+		removedinstr += func->end - func->start;
+	}
+
+	ok = rewrite_finish();
+	if (ok)
+		ok = write_qvm(qvmfile) && write_map(mapfile);
+
+	newlen = newcount ? newcode[newcount - 1].offset + 1 + opcodeparamsize(newcode[newcount - 1].opcode) : 0;
+	newlen = (newlen + 3) & ~3;
+	printf("Removed %d of %d functions (%d instructions), code segment %d -> %d bytes (%d saved)\n",
+		removed, functioncount, removedinstr, oldlen, newlen, oldlen - newlen);
+
+	rewrite_end();
+	return ok;
+}
@@ -0,0 +1,33 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_STRIP_H
+#define QVMOPS_STRIP_H
+
+#include "qvm.h"
+
+// is each function reachable from vmMain (or address-taken)
+extern uint8_t reachable[MAX_FUNCTIONS];
+
+// is each function's address used other than to call it directly
+extern uint8_t addresstaken[MAX_FUNCTIONS];
+
+// mark functions whose address is used other than to call them directly, by code (OP_CONST) or data (function pointers)
+void find_address_taken(void);
+
+// mark functions reachable from vmMain through direct calls, and from any function whose address is taken
+void find_reachable(void);
+
+// write a copy of the loaded qvm (and map) with unreachable functions removed
+int strip_qvm(const char* qvmfile, const char* mapfile);
+
+#endif // QVMOPS_STRIP_H
@@ -15,6 +15,7 @@ Created By:
 #include <string.h>
 #include <stdlib.h>
 #include "symbols.h"
+#include "stats.h"
 #include "util.h"
 
 symbolmap_t symbols[SEGMENT_COUNT][MAX_SYMBOLS];
@@ -23,6 +24,13 @@ int symbolcount[SEGMENT_COUNT];
 symbolmap_t lines[MAX_LINES];
 int linecount;
 
+// open-addressed hash table of symbols by name
+#define SYMBOL_HASH_SIZE 65536
+static symbolmap_t* symbolhash[SYMBOL_HASH_SIZE];
+
+static void hash_symbols(void);
+
+static int add_map_line(char* line);
 static symbolmap_t parse_map_line_ex(char* line);
 static symbolmap_t parse_map_line(char* line);
 
@@ -32,7 +40,8 @@ void parse_map(const char* file) {
 	char* line = NULL;
 	size_t linelen = 0;
 	ssize_t ret;
-	int segment = 0;
+
+	free_map();
 
 	printf("Opening %s...\n", file);
 
@@ -46,25 +55,13 @@ void parse_map(const char* file) {
 		// empty line
 		if (!line || !*line || !linelen)
 			continue;
-		symbolmap_t symbol = parse_map_line(line);
-		segment = symbol.segment;
-		// invalid line
-		if (segment < 0)
-			continue;
-
-		symbol.index = symbolcount[segment];
-
-		symbols[segment][symbolcount[segment]] = symbol;
-
-		symbolcount[segment]++;
-		
-		if (symbolcount[segment] >= MAX_SYMBOLS) {
-			fprintf(stderr, "File not found: %s\n", file);
-			goto fail;
-		}
+		if (!add_map_line(line))
+			break;
 	}
 
+	free(line);
 	fclose(h);
+	hash_symbols();
 	return;
 
 fail:
@@ -73,12 +70,81 @@ fail:
 }
 
 
+// fill symbols array with data from a map file already in memory
+void parse_map_buffer(const char* buf, int size) {
+	char line[1024];
+	const char* end = buf + size;
+
+	free_map();
+
+	while (buf < end) {
+		const char* eol = memchr(buf, '\n', end - buf);
+		size_t len;
+		if (!eol)
+			eol = end;
+		len = eol - buf;
+		if (len >= sizeof(line))
+			len = sizeof(line) - 1;
+		memcpy(line, buf, len);
+		line[len] = '\0';
+		buf = eol + 1;
+
+		// empty line
+		if (!*line)
+			continue;
+		if (!add_map_line(line))
+			break;
+	}
+
+	hash_symbols();
+}
+
+
+// free symbols from a previously loaded map
+void free_map(void) {
+	for (int segment = 0; segment < SEGMENT_COUNT; segment++) {
+		for (int i = 0; i < symbolcount[segment]; i++)
+			free(symbols[segment][i].symbol);
+		symbolcount[segment] = 0;
+	}
+	for (int i = 0; i < linecount; i++)
+		free(lines[i].symbol);
+	linecount = 0;
+	memset(symbolhash, 0, sizeof(symbolhash));
+}
+
+
+// parse a map line and add it to the symbols array, returns 0 if the array is full
+static int add_map_line(char* line) {
+	symbolmap_t symbol = parse_map_line(line);
+	int segment = symbol.segment;
+	// invalid line
+	if (segment < 0)
+		return 1;
+
+	symbol.index = symbolcount[segment];
+
+	symbols[segment][symbolcount[segment]] = symbol;
+
+	symbolcount[segment]++;
+
+	if (symbolcount[segment] >= MAX_SYMBOLS) {
+		fprintf(stderr, "Too many symbols in segment %d, only the first %d are loaded\n", segment, MAX_SYMBOLS);
+		return 0;
+	}
+
+	return 1;
+}
+
+
 // find a line by instruction index (after given symbol index)
 symbolmap_t* find_line(int index, int after) {
 	if (!linecount || after < -1 || after > linecount)
 		return NULL;
 
+	stats.line_lookups++;
 	for (int i = after + 1; i < linecount; i++) {
+		stats.line_scans++;
 		if (lines[i].offset == index)
 			return &lines[i];
 
@@ -97,7 +163,9 @@ symbolmap_t* find_code_symbol(int index, int after) {
 
 	// find the symbol with the highest offset that is less than the desired one
 	int likely_symbol = -1;
+	stats.symbol_lookups++;
 	for (int i = after + 1; i < symbolcount[segment]; i++) {
+		stats.symbol_scans++;
 		if (symbols[segment][i].offset == index)
 			return &symbols[segment][i];
 
@@ -131,7 +199,9 @@ symbolmap_t* find_data_symbol(int offset, int after) {
 
 	// find the symbol with the highest offset that is less than the desired one
 	int likely_symbol = -1;
+	stats.symbol_lookups++;
 	for (int i = after + 1; i < symbolcount[segment]; i++) {
+		stats.symbol_scans++;
 		if (symbols[segment][i].offset == offset)
 			return &symbols[segment][i];
 
@@ -148,6 +218,98 @@ symbolmap_t* find_data_symbol(int offset, int after) {
 }
 
 
+// name of the function starting at an instruction index ("funcN" if no symbol)
+// negative indexes are system calls ("trapN" if no symbol)
+const char* function_name(int index) {
+	static char buf[32];
+	symbolmap_t* symbol = find_code_symbol(index, -1);
+
+	// find_code_symbol may return the closest preceding symbol, only an exact match counts
+	if (symbol && symbol->offset == index)
+		return symbol->symbol;
+
+	if (index < 0)
+		snprintf(buf, sizeof(buf), "trap%d", -index - 1);
+	else
+		snprintf(buf, sizeof(buf), "func%d", index);
+	return buf;
+}
+
+
+// FNV-1a hash of a symbol name
+static unsigned int hash_name(const char* name) {
+	unsigned int hash = 2166136261u;
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+// build name lookup table for all loaded symbols
+static void hash_symbols(void) {
+	memset(symbolhash, 0, sizeof(symbolhash));
+
+	for (int segment = 0; segment < SEGMENT_COUNT; segment++) {
+		for (int i = 0; i < symbolcount[segment]; i++) {
+			symbolmap_t* symbol = &symbols[segment][i];
+			unsigned int slot = hash_name(symbol->symbol) & (SYMBOL_HASH_SIZE - 1);
+			// keep the first symbol with a given name
+			while (symbolhash[slot] && strcmp(symbolhash[slot]->symbol, symbol->symbol))
+				slot = (slot + 1) & (SYMBOL_HASH_SIZE - 1);
+			if (!symbolhash[slot])
+				symbolhash[slot] = symbol;
+		}
+	}
+}
+
+
+// find a symbol by name (any segment)
+symbolmap_t* find_symbol_by_name(const char* name) {
+	unsigned int slot = hash_name(name) & (SYMBOL_HASH_SIZE - 1);
+
+	stats.symbol_lookups++;
+	while (symbolhash[slot]) {
+		stats.symbol_scans++;
+		if (!strcmp(symbolhash[slot]->symbol, name))
+			return symbolhash[slot];
+		slot = (slot + 1) & (SYMBOL_HASH_SIZE - 1);
+	}
+
+	return NULL;
+}
+
+
+// absolute data address of a data/lit/bss symbol
+int data_symbol_address(const symbolmap_t* symbol) {
+	switch (symbol->segment) {
+	case SEGMENT_DATA:
+		return symbol->offset;
+	case SEGMENT_LIT:
+		return datasize[SEGMENT_DATA] + symbol->offset;
+	case SEGMENT_BSS:
+		return datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT] + symbol->offset;
+	default:
+		return -1;
+	}
+}
+
+
+// size of a data/lit/bss symbol (distance to the next symbol in its segment)
+int data_symbol_size(const symbolmap_t* symbol) {
+	int segment = symbol->segment;
+	int next = datasize[segment];
+
+	for (int i = 0; i < symbolcount[segment]; i++) {
+		if (symbols[segment][i].offset > symbol->offset && symbols[segment][i].offset < next)
+			next = symbols[segment][i].offset;
+	}
+
+	return next - symbol->offset;
+}
+
+
 // parse a line from the .map file from stvoymp, which adds extra stuff
 static symbolmap_t parse_map_line_ex(char* line) {
 	char buf[4][256] = { 0, };
@@ -34,7 +34,24 @@ symbolmap_t* find_line(int index, int after);
 symbolmap_t* find_code_symbol(int index, int after);
 symbolmap_t* find_data_symbol(int offset, int after);
 
+// name of the function starting at an instruction index ("funcN" if no symbol)
+// negative indexes are system calls ("trapN" if no symbol)
+const char* function_name(int index);
+
+// find a symbol by name (any segment)
+symbolmap_t* find_symbol_by_name(const char* name);
+
+// absolute data address of a data/lit/bss symbol
+int data_symbol_address(const symbolmap_t* symbol);
+
+// size of a data/lit/bss symbol (distance to the next symbol in its segment)
+int data_symbol_size(const symbolmap_t* symbol);
+
 // fill symbols array with data from map file
 void parse_map(const char* file);
+void parse_map_buffer(const char* buf, int size);
+
+// free symbols from a previously loaded map
+void free_map(void);
 
 #endif // QVMOPS_SYMBOLS_H
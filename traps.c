@@ -0,0 +1,168 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "qvm.h"
+#include "symbols.h"
+#include "traps.h"
+
+trapcall_t trapcalls[MAX_TRAPCALLS];
+int trapcallcount;
+
+// histogram entry for a trap or a function
+typedef struct traphist_s {
+	int id;				// trap number or index into functions[]
+	int calls;			// number of call sites
+	int distinct;		// number of different callers/traps
+	int minargs;
+	int maxargs;
+} traphist_t;
+
+
+// number of OP_ARG instructions since the previous call in the function
+// lcc evaluates nested calls before storing any arguments, so the arguments for
+// a call are always the OP_ARGs between it and the previous OP_CALL
+int count_call_args(int index) {
+	int argc = 0;
+
+	for (int i = index - 1; i >= 0; i--) {
+		vmop_t op = instructions[i].opcode;
+		if (op == OP_CALL || op == OP_ENTER)
+			break;
+		if (op == OP_ARG)
+			argc++;
+	}
+
+	return argc;
+}
+
+
+// fill trapcalls array
+void find_trap_calls(void) {
+	trapcallcount = 0;
+
+	for (int f = 0; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		for (int index = func->start + 1; index < func->end; index++) {
+			if (instructions[index].opcode != OP_CALL || instructions[index - 1].opcode != OP_CONST || instructions[index - 1].param >= 0)
+				continue;
+			if (trapcallcount >= MAX_TRAPCALLS) {
+				fprintf(stderr, "Too many trap calls, only the first %d are indexed\n", MAX_TRAPCALLS);
+				return;
+			}
+			trapcalls[trapcallcount].index = index;
+			trapcalls[trapcallcount].func = f;
+			trapcalls[trapcallcount].trap = -instructions[index - 1].param - 1;
+			trapcalls[trapcallcount].argc = count_call_args(index - 1);
+			trapcallcount++;
+		}
+	}
+}
+
+
+// sort by number of calls, highest first
+static int compare_hist(const void* a, const void* b) {
+	const traphist_t* ha = (const traphist_t*)a;
+	const traphist_t* hb = (const traphist_t*)b;
+	if (ha->calls != hb->calls)
+		return hb->calls - ha->calls;
+	return ha->id - hb->id;
+}
+
+
+// add a call site to a histogram entry
+static void add_hist(traphist_t* hist, int id, int argc) {
+	hist->id = id;
+	if (!hist->calls || argc < hist->minargs)
+		hist->minargs = argc;
+	if (!hist->calls || argc > hist->maxargs)
+		hist->maxargs = argc;
+	hist->calls++;
+}
+
+
+// output trap call-site index and per-trap/per-function histograms
+void report_traps(output_t* h) {
+	traphist_t* bytrap = NULL;
+	traphist_t* byfunc = NULL;
+	int* last = NULL;
+	int maxtrap = -1;
+
+	puts("Processing trap call report...");
+
+	find_trap_calls();
+
+	for (int i = 0; i < trapcallcount; i++) {
+		if (trapcalls[i].trap > maxtrap)
+			maxtrap = trapcalls[i].trap;
+	}
+
+	bytrap = (traphist_t*)calloc(maxtrap + 2, sizeof(traphist_t));
+	byfunc = (traphist_t*)calloc(functioncount + 1, sizeof(traphist_t));
+	last = (int*)malloc((maxtrap + 2) * sizeof(int));
+	if (!bytrap || !byfunc || !last) {
+		fprintf(stderr, "Unable to allocate trap report memory\n");
+		goto done;
+	}
+
+	// call sites are in instruction order, so all calls from a function are grouped together.
+	// this lets distinct callers/traps be counted by remembering the last caller of each trap
+	for (int i = 0; i <= maxtrap; i++)
+		last[i] = -1;
+	for (int i = 0; i < trapcallcount; i++) {
+		trapcall_t* call = &trapcalls[i];
+		add_hist(&bytrap[call->trap], call->trap, call->argc);
+		add_hist(&byfunc[call->func], call->func, call->argc);
+		if (last[call->trap] != call->func) {
+			bytrap[call->trap].distinct++;
+			byfunc[call->func].distinct++;
+			last[call->trap] = call->func;
+		}
+	}
+
+	out_puts(h, "\n\nTRAP CALLS\n==========\n");
+	out_printf(h, "%d trap call sites\n", trapcallcount);
+
+	out_puts(h, "\nBy trap:\n");
+	out_printf(h, "%8s %8s %6s  %s\n", "CALLS", "CALLERS", "ARGS", "TRAP");
+	qsort(bytrap, maxtrap + 1, sizeof(traphist_t), compare_hist);
+	for (int i = 0; i <= maxtrap && bytrap[i].calls; i++) {
+		char args[16];
+		if (bytrap[i].minargs == bytrap[i].maxargs)
+			snprintf(args, sizeof(args), "%d", bytrap[i].minargs);
+		else
+			snprintf(args, sizeof(args), "%d-%d", bytrap[i].minargs, bytrap[i].maxargs);
+		out_printf(h, "%8d %8d %6s  %s (%d)\n", bytrap[i].calls, bytrap[i].distinct, args, function_name(-bytrap[i].id - 1), bytrap[i].id);
+	}
+
+	out_puts(h, "\nBy function:\n");
+	out_printf(h, "%8s %8s  %s\n", "CALLS", "TRAPS", "FUNCTION");
+	qsort(byfunc, functioncount, sizeof(traphist_t), compare_hist);
+	for (int i = 0; i < functioncount && byfunc[i].calls; i++)
+		out_printf(h, "%8d %8d  %s\n", byfunc[i].calls, byfunc[i].distinct, function_name(functions[byfunc[i].id].start));
+
+	out_puts(h, "\nCall sites:\n");
+	out_printf(h, "%6s %5s  %-32s %s\n", "INDEX", "ARGS", "TRAP", "CALLER");
+	for (int i = 0; i < trapcallcount; i++) {
+		trapcall_t* call = &trapcalls[i];
+		function_t* func = &functions[call->func];
+		// function_name uses a static buffer, so output one name at a time
+		out_printf(h, "%06d %5d  ", call->index, call->argc);
+		out_printf(h, "%-32s ", function_name(-call->trap - 1));
+		out_printf(h, "%s+%d\n", function_name(func->start), call->index - func->start);
+	}
+
+done:
+	free(bytrap);
+	free(byfunc);
+	free(last);
+}
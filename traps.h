@@ -0,0 +1,38 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_TRAPS_H
+#define QVMOPS_TRAPS_H
+
+#include "output.h"
+
+#define MAX_TRAPCALLS 100000
+// a single system call site
+typedef struct trapcall_s {
+	int index;			// instruction index of OP_CALL
+	int func;			// index into functions[] of caller
+	int trap;			// trap number (OP_CONST param is -trap-1)
+	int argc;			// number of OP_ARG instructions leading up to the call
+} trapcall_t;
+extern trapcall_t trapcalls[MAX_TRAPCALLS];
+extern int trapcallcount;
+
+// number of OP_ARG instructions since the previous call in the function
+int count_call_args(int index);
+
+// fill trapcalls array
+void find_trap_calls(void);
+
+// output trap call-site index and per-trap/per-function histograms
+void report_traps(output_t* h);
+
+#endif // QVMOPS_TRAPS_H
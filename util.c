@@ -14,6 +14,13 @@ Created By:
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 #include "util.h"
 
 
@@ -61,6 +68,69 @@ char* strrstr(const char* str, const char* substr) {
 }
 
 
+// case-insensitive string comparison, returns 1 if equal
+int striequal(const char* s1, const char* s2) {
+	while (*s1 && tolower((uint8_t)*s1) == tolower((uint8_t)*s2)) {
+		s1++;
+		s2++;
+	}
+	return tolower((uint8_t)*s1) == tolower((uint8_t)*s2);
+}
+
+
+// case-insensitive check if str ends with suffix
+int striendswith(const char* str, const char* suffix) {
+	size_t len = strlen(str);
+	size_t suffixlen = strlen(suffix);
+	if (suffixlen > len)
+		return 0;
+	return striequal(str + len - suffixlen, suffix);
+}
+
+
+// update a CRC-32 (as used by zip/gzip) with len bytes
+uint32_t crc32_buf(uint32_t crc, const uint8_t* buf, size_t len) {
+	static uint32_t table[256];
+	static int built = 0;
+
+	if (!built) {
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+		built = 1;
+	}
+
+	crc = ~crc;
+	while (len--)
+		crc = table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+
+// update an FNV-1a hash with len bytes
+uint32_t fnv1a_buf(uint32_t hash, const void* buf, size_t len) {
+	const uint8_t* p = (const uint8_t*)buf;
+	while (len--)
+		hash = (hash ^ *p++) * 16777619u;
+	return hash;
+}
+
+
+// create a directory, returns 1 if it was created or already exists
+int make_dir(const char* path) {
+#ifdef _WIN32
+	if (!_mkdir(path))
+#else
+	if (!mkdir(path, 0777))
+#endif
+		return 1;
+	return errno == EEXIST;
+}
+
+
 #ifdef _MSC_VER
 // https://stackoverflow.com/questions/735126/a/47229318#47229318
 ssize_t getline(char** lineptr, size_t* n, FILE* stream) {
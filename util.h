@@ -28,6 +28,23 @@ char printablec(uint8_t c);
 // reverse version of strstr (search backwards from end of string)
 char* strrstr(const char* str, const char* substr);
 
+// case-insensitive string comparison, returns 1 if equal
+int striequal(const char* s1, const char* s2);
+
+// case-insensitive check if str ends with suffix
+int striendswith(const char* str, const char* suffix);
+
+// update a CRC-32 (as used by zip/gzip) with len bytes
+uint32_t crc32_buf(uint32_t crc, const uint8_t* buf, size_t len);
+
+// starting value for fnv1a_buf
+#define FNV1A_INIT	2166136261u
+// update an FNV-1a hash with len bytes
+uint32_t fnv1a_buf(uint32_t hash, const void* buf, size_t len);
+
+// create a directory, returns 1 if it was created or already exists
+int make_dir(const char* path);
+
 #ifdef _MSC_VER
 #define MINIMUM_BUFFER_SIZE 128
 typedef intptr_t ssize_t;
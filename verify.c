@@ -0,0 +1,288 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include "qvm.h"
+#include "analysis.h"
+#include "jumptable.h"
+#include "verify.h"
+
+// max tracked depth of the abstract operand stack
+#define VERIFY_STACK	64
+
+FILE* verifylog;
+
+static int diagnostics;
+static int errors;
+
+
+// output a diagnostic line: name, instruction index (-1 for whole file), severity, code, message
+// fields are tab-separated, since names of files inside pk3s contain ':'
+void verify_report(const char* name, int index, const char* severity, const char* code, const char* fmt, ...) {
+	FILE* h = verifylog ? verifylog : stderr;
+	va_list args;
+
+	if (!strcmp(severity, "error"))
+		errors++;
+	if (++diagnostics > MAX_DIAGNOSTICS) {
+		if (diagnostics == MAX_DIAGNOSTICS + 1)
+			fprintf(h, "%s\t-1\tnote\ttoo-many-diagnostics\tfurther diagnostics suppressed\n", name);
+		fflush(h);
+		return;
+	}
+
+	fprintf(h, "%s\t%d\t%s\t%s\t", name, index, severity, code);
+	va_start(args, fmt);
+	vfprintf(h, fmt, args);
+	va_end(args);
+	fputc('\n', h);
+	// whole lines, so worker processes writing the same log don't interleave them
+	fflush(h);
+}
+
+
+// abstract operand stack entry: a known constant or unknown
+typedef struct absval_s {
+	int known;
+	int value;
+} absval_t;
+
+typedef struct absstack_s {
+	absval_t vals[VERIFY_STACK];
+	int depth;
+} absstack_t;
+
+
+static absval_t abs_pop(absstack_t* stack) {
+	absval_t unknown = { 0, 0 };
+	// popping past what we know about (e.g. after a branch target) gives an unknown value
+	if (stack->depth <= 0)
+		return unknown;
+	return stack->vals[--stack->depth];
+}
+
+
+static void abs_push(absstack_t* stack, int known, int value) {
+	if (stack->depth >= VERIFY_STACK) {
+		// drop the oldest half rather than tracking a runaway stack
+		memmove(stack->vals, stack->vals + VERIFY_STACK / 2, sizeof(absval_t) * (VERIFY_STACK / 2));
+		stack->depth = VERIFY_STACK / 2;
+	}
+	stack->vals[stack->depth].known = known;
+	stack->vals[stack->depth].value = value;
+	stack->depth++;
+}
+
+
+// check a statically known data access against the data image
+static void check_address(const char* name, int index, absval_t addr, int size) {
+	int imagesize = datasize[SEGMENT_DATA] + datasize[SEGMENT_LIT] + datasize[SEGMENT_BSS];
+
+	if (!addr.known)
+		return;
+	if (addr.value < 0 || size < 0 || addr.value > imagesize - size)
+		verify_report(name, index, "error", "data-address-out-of-range", "%s of %d bytes at 0x%X is outside data image (0x%X bytes)", opcodename(instructions[index].opcode), size, addr.value, imagesize);
+}
+
+
+// check code flow and frames of each instruction
+static void verify_code(const char* name, uint8_t* targets) {
+	int framesize = -1;
+	int enter_index = -1;
+	int leaves = 0;
+	int pending_arg = -1;
+
+	for (int index = 0; index < instructioncount; index++) {
+		instruction_t* instr = &instructions[index];
+		instruction_t* prev = index > 0 ? &instructions[index - 1] : NULL;
+
+		if (instr->opcode <= OP_UNDEF || instr->opcode >= OP_COUNT) {
+			verify_report(name, index, "error", "invalid-opcode", "invalid opcode %d", instr->opcode);
+			continue;
+		}
+
+		switch (instr->opcode) {
+		case OP_ENTER:
+			if (enter_index >= 0 && !leaves)
+				verify_report(name, enter_index, "error", "missing-leave", "function has no OP_LEAVE");
+			if (pending_arg >= 0)
+				verify_report(name, pending_arg, "error", "arg-outside-call", "OP_ARG not followed by OP_CALL in the same function");
+			enter_index = index;
+			framesize = instr->param;
+			leaves = 0;
+			pending_arg = -1;
+			if (framesize < 8 || framesize & 3)
+				verify_report(name, index, "error", "invalid-frame-size", "frame size %d is not a multiple of 4 of at least 8", framesize);
+			else if (framesize >= PROGRAM_STACK_SIZE)
+				verify_report(name, index, "error", "frame-too-large", "frame size %d exceeds program stack size %d", framesize, PROGRAM_STACK_SIZE);
+			break;
+		case OP_LEAVE:
+			if (enter_index < 0) {
+				verify_report(name, index, "error", "leave-outside-function", "OP_LEAVE before any OP_ENTER");
+				break;
+			}
+			leaves++;
+			if (instr->param != framesize)
+				verify_report(name, index, "error", "frame-mismatch", "OP_LEAVE frame size %d does not match OP_ENTER frame size %d", instr->param, framesize);
+			if (pending_arg >= 0) {
+				verify_report(name, pending_arg, "error", "arg-outside-call", "OP_ARG not followed by OP_CALL in the same function");
+				pending_arg = -1;
+			}
+			break;
+		case OP_ARG:
+			if (pending_arg < 0)
+				pending_arg = index;
+			// arguments are stored in the outgoing area at the bottom of the caller's frame
+			if (instr->param < 8 || (framesize >= 0 && instr->param + 4 > framesize))
+				verify_report(name, index, "error", "arg-outside-frame", "OP_ARG offset %d is outside frame of size %d", instr->param, framesize);
+			break;
+		case OP_CALL:
+			pending_arg = -1;
+			if (prev && prev->opcode == OP_CONST && prev->param >= 0) {
+				if (prev->param >= instructioncount)
+					verify_report(name, index, "error", "call-target-out-of-range", "call target %d is outside code segment (%d instructions)", prev->param, instructioncount);
+				else if (instructions[prev->param].opcode != OP_ENTER)
+					verify_report(name, index, "error", "call-target-not-function", "call target %d is not an OP_ENTER", prev->param);
+			}
+			break;
+		case OP_JUMP:
+			if (prev && prev->opcode == OP_CONST) {
+				if (prev->param < 0 || prev->param >= instructioncount)
+					verify_report(name, index, "error", "jump-target-out-of-range", "jump target %d is outside code segment (%d instructions)", prev->param, instructioncount);
+				else
+					targets[prev->param] = 1;
+			}
+			break;
+		case OP_LOCAL:
+			if (instr->param < 0)
+				verify_report(name, index, "error", "invalid-local", "negative local offset %d", instr->param);
+			break;
+		case OP_BLOCK_COPY:
+			if (instr->param < 0)
+				verify_report(name, index, "error", "invalid-block-copy", "negative block copy size %d", instr->param);
+			break;
+		default:
+			if (is_branch(instr->opcode)) {
+				if (instr->param < 0 || instr->param >= instructioncount)
+					verify_report(name, index, "error", "branch-target-out-of-range", "branch target %d is outside code segment (%d instructions)", instr->param, instructioncount);
+				else
+					targets[instr->param] = 1;
+			}
+		}
+	}
+
+	if (enter_index >= 0 && !leaves)
+		verify_report(name, enter_index, "error", "missing-leave", "function has no OP_LEAVE");
+	if (pending_arg >= 0)
+		verify_report(name, pending_arg, "error", "arg-outside-call", "OP_ARG not followed by OP_CALL in the same function");
+}
+
+
+// check statically known data addresses by tracking constants on the operand stack
+static void verify_data_access(const char* name, const uint8_t* targets) {
+	absstack_t stack;
+
+	stack.depth = 0;
+
+	for (int index = 0; index < instructioncount; index++) {
+		instruction_t* instr = &instructions[index];
+		absval_t a, b;
+		int pops, pushes;
+
+		// values reaching a branch target may come from elsewhere
+		if (targets[index] || instr->opcode == OP_ENTER)
+			stack.depth = 0;
+
+		switch (instr->opcode) {
+		case OP_CONST:
+			abs_push(&stack, 1, instr->param);
+			break;
+		case OP_ADD:
+		case OP_SUB:
+			b = abs_pop(&stack);
+			a = abs_pop(&stack);
+			if (instr->opcode == OP_ADD)
+				abs_push(&stack, a.known && b.known, (int)((unsigned)a.value + (unsigned)b.value));
+			else
+				abs_push(&stack, a.known && b.known, (int)((unsigned)a.value - (unsigned)b.value));
+			break;
+		case OP_LOAD1:
+		case OP_LOAD2:
+		case OP_LOAD4:
+			a = abs_pop(&stack);
+			check_address(name, index, a, instr->opcode == OP_LOAD1 ? 1 : instr->opcode == OP_LOAD2 ? 2 : 4);
+			abs_push(&stack, 0, 0);
+			break;
+		case OP_STORE1:
+		case OP_STORE2:
+		case OP_STORE4:
+			abs_pop(&stack);
+			a = abs_pop(&stack);
+			check_address(name, index, a, instr->opcode == OP_STORE1 ? 1 : instr->opcode == OP_STORE2 ? 2 : 4);
+			break;
+		case OP_BLOCK_COPY:
+			b = abs_pop(&stack);
+			a = abs_pop(&stack);
+			check_address(name, index, a, instr->param);
+			check_address(name, index, b, instr->param);
+			break;
+		default:
+			opcodestack(instr->opcode, &pops, &pushes);
+			while (pops--)
+				abs_pop(&stack);
+			while (pushes--)
+				abs_push(&stack, 0, 0);
+		}
+
+		// nothing on the stack is known to carry past an unconditional jump or return
+		if (instr->opcode == OP_JUMP || instr->opcode == OP_LEAVE)
+			stack.depth = 0;
+	}
+}
+
+
+// verify the currently loaded qvm, returns number of errors found
+int verify_qvm(const char* name) {
+	uint8_t* targets;
+
+	puts("Verifying code segment...");
+
+	diagnostics = 0;
+	errors = 0;
+
+	if (header.bsslen < 0 || header.datalen < 0 || header.litlen < 0)
+		verify_report(name, -1, "error", "invalid-header", "negative segment length");
+	if (!instructioncount || instructions[0].opcode != OP_ENTER)
+		verify_report(name, 0, "error", "missing-entry", "code segment does not start with OP_ENTER (vmMain)");
+
+	targets = (uint8_t*)calloc(instructioncount + 1, 1);
+	if (!targets) {
+		fprintf(stderr, "Unable to allocate verify memory\n");
+		return 1;
+	}
+
+	verify_code(name, targets);
+	// switch cases are reached from their table as well
+	for (int t = 0; t < jumptablecount; t++) {
+		for (int i = 0; i < jumptables[t].count; i++)
+			targets[jumptable_target(&jumptables[t], i)] = 1;
+	}
+	verify_data_access(name, targets);
+
+	free(targets);
+
+	printf("%s: %d error(s), %d diagnostic(s)\n", name, errors, diagnostics);
+
+	return errors;
+}
@@ -0,0 +1,30 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_VERIFY_H
+#define QVMOPS_VERIFY_H
+
+#include <stdio.h>
+
+// stop reporting diagnostics for a file after this many
+#define MAX_DIAGNOSTICS	100
+
+// where diagnostics are written (stderr if NULL), kept apart from progress output on stdout
+extern FILE* verifylog;
+
+// output a diagnostic line: name, instruction index (-1 for whole file), severity, code, message
+void verify_report(const char* name, int index, const char* severity, const char* code, const char* fmt, ...);
+
+// verify the currently loaded qvm, returns number of errors found
+int verify_qvm(const char* name);
+
+#endif // QVMOPS_VERIFY_H
@@ -0,0 +1,323 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#define stat _stat
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#else
+#include <unistd.h>
+#endif
+#include "qvm.h"
+#include "symbols.h"
+#include "util.h"
+#include "jumptable.h"
+#include "watch.h"
+
+#define MAX_WATCH_FILES	4
+
+static char watchfiles[MAX_WATCH_FILES][1024];
+static int watchcount;
+
+#ifdef __linux__
+static int watchfd = -1;
+#else
+// size and modification time of each file when last checked
+static struct stat watchstat[MAX_WATCH_FILES];
+#endif
+
+// hash of each output file written, by filename
+#define OUTPUT_HASH_SIZE	131072
+typedef struct outputhash_s {
+	char* file;
+	uint32_t hash;
+	int generation;			// sweep generation the file was last seen in, -1 once deleted
+} outputhash_t;
+static outputhash_t* outputs;
+static int generation;
+
+
+#ifdef __linux__
+// start watching files for changes
+// the directories are watched, since compilers and editors often replace a file rather than rewrite it
+int watch_begin(const char** files, int count) {
+	watchfd = inotify_init();
+	if (watchfd < 0) {
+		fprintf(stderr, "Unable to watch files: %s\n", strerror(errno));
+		return 0;
+	}
+
+	watchcount = 0;
+	for (int i = 0; i < count && watchcount < MAX_WATCH_FILES; i++) {
+		char dir[1024];
+		char* slash;
+
+		strncpyz(watchfiles[watchcount++], files[i], sizeof(watchfiles[0]));
+		strncpyz(dir, files[i], sizeof(dir));
+		slash = strrchr(dir, '/');
+		if (slash)
+			*(slash == dir ? slash + 1 : slash) = '\0';
+		else
+			strncpyz(dir, ".", sizeof(dir));
+
+		if (inotify_add_watch(watchfd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+			fprintf(stderr, "Unable to watch %s: %s\n", dir, strerror(errno));
+			watch_end();
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+// is this the filename part of a watched file
+static int is_watched(const char* name) {
+	for (int i = 0; i < watchcount; i++) {
+		const char* slash = strrchr(watchfiles[i], '/');
+		if (!strcmp(slash ? slash + 1 : watchfiles[i], name))
+			return 1;
+	}
+	return 0;
+}
+
+
+// block until a watched file has changed and settled, returns 0 on error
+int watch_wait(void) {
+	char buf[4096];
+	int changed = 0;
+
+	for (;;) {
+		struct pollfd pfd = { watchfd, POLLIN, 0 };
+		ssize_t len;
+		int ret = poll(&pfd, 1, changed ? WATCH_SETTLE_MS : -1);
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "Error watching files: %s\n", strerror(errno));
+			return 0;
+		}
+		// nothing more happened for a while
+		if (!ret)
+			return 1;
+
+		len = read(watchfd, buf, sizeof(buf));
+		if (len <= 0) {
+			fprintf(stderr, "Error watching files: %s\n", strerror(errno));
+			return 0;
+		}
+		for (char* p = buf; p < buf + len; ) {
+			struct inotify_event* event = (struct inotify_event*)p;
+			if (event->len && is_watched(event->name))
+				changed = 1;
+			p += sizeof(struct inotify_event) + event->len;
+		}
+	}
+}
+#else
+// wait a number of milliseconds
+static void sleep_ms(int ms) {
+#ifdef _WIN32
+	Sleep(ms);
+#else
+	usleep(ms * 1000);
+#endif
+}
+
+
+// check files against their last known size and modification time, and update them
+static int files_changed(void) {
+	int changed = 0;
+
+	for (int i = 0; i < watchcount; i++) {
+		struct stat st;
+		if (stat(watchfiles[i], &st))
+			memset(&st, 0, sizeof(st));
+		if (st.st_size != watchstat[i].st_size || st.st_mtime != watchstat[i].st_mtime)
+			changed = 1;
+		watchstat[i] = st;
+	}
+
+	return changed;
+}
+
+
+// start watching files for changes
+int watch_begin(const char** files, int count) {
+	watchcount = 0;
+	for (int i = 0; i < count && watchcount < MAX_WATCH_FILES; i++)
+		strncpyz(watchfiles[watchcount++], files[i], sizeof(watchfiles[0]));
+	files_changed();
+	return 1;
+}
+
+
+// block until a watched file has changed and settled, returns 0 on error
+int watch_wait(void) {
+	while (!files_changed())
+		sleep_ms(WATCH_POLL_MS);
+	do {
+		sleep_ms(WATCH_SETTLE_MS);
+	} while (files_changed());
+	return 1;
+}
+#endif
+
+
+// stop watching files and forget output hashes
+void watch_end(void) {
+#ifdef __linux__
+	if (watchfd >= 0)
+		close(watchfd);
+	watchfd = -1;
+#endif
+	watchcount = 0;
+
+	if (outputs) {
+		for (int i = 0; i < OUTPUT_HASH_SIZE; i++)
+			free(outputs[i].file);
+		free(outputs);
+		outputs = NULL;
+	}
+}
+
+
+// hash of the names and offsets of all symbols
+// instructions are annotated with symbols from elsewhere in the qvm, so any symbol change can affect every function
+uint32_t watch_hash_symbols(void) {
+	uint32_t hash = FNV1A_INIT;
+
+	for (int segment = 0; segment < SEGMENT_COUNT; segment++) {
+		for (int i = 0; i < symbolcount[segment]; i++) {
+			symbolmap_t* symbol = &symbols[segment][i];
+			hash = fnv1a_buf(hash, &symbol->offset, sizeof(symbol->offset));
+			hash = fnv1a_buf(hash, symbol->symbol, strlen(symbol->symbol) + 1);
+		}
+	}
+
+	return hash;
+}
+
+
+// sort lines by instruction index
+static int compare_line_offset(const void* a, const void* b) {
+	const symbolmap_t* la = &lines[*(const int*)a];
+	const symbolmap_t* lb = &lines[*(const int*)b];
+	if (la->offset != lb->offset)
+		return la->offset - lb->offset;
+	return la->index - lb->index;
+}
+
+
+// hash of everything that affects the disassembly of each function: the symbol hash, the segment sizes and
+// instruction count (annotations check addresses against them), its position (output shows instruction indexes
+// and offsets), its instructions, the entries of its switch tables, and the line numbers inside it
+// returns 0 if out of memory
+int watch_hash_functions(uint32_t symhash, uint32_t* hashes) {
+	int* order = (int*)malloc((linecount + 1) * sizeof(int));
+	int l = 0;
+
+	if (!order)
+		return 0;
+	// map lines aren't necessarily in code order, so sort them once and walk them alongside the functions
+	for (int i = 0; i < linecount; i++)
+		order[i] = i;
+	qsort(order, linecount, sizeof(int), compare_line_offset);
+
+	for (int f = 0; f < functioncount; f++) {
+		function_t* func = &functions[f];
+		uint32_t hash = FNV1A_INIT;
+
+		hash = fnv1a_buf(hash, &symhash, sizeof(symhash));
+		hash = fnv1a_buf(hash, datasize, sizeof(datasize));
+		hash = fnv1a_buf(hash, &instructioncount, sizeof(instructioncount));
+		hash = fnv1a_buf(hash, &func->start, sizeof(func->start));
+		hash = fnv1a_buf(hash, &get_instruction(func->start)->offset, sizeof(int));
+		for (int index = func->start; index < func->end; index++) {
+			instruction_t* instr = get_instruction(index);
+			jumptable_t* table;
+			hash = fnv1a_buf(hash, &instr->opcode, sizeof(vmop_t));
+			hash = fnv1a_buf(hash, &instr->param, sizeof(int));
+			if (instr->opcode == OP_JUMP && (table = find_jumptable(index)))
+				hash = fnv1a_buf(hash, data + table->address, table->count * sizeof(int));
+		}
+
+		while (l < linecount && lines[order[l]].offset < func->start)
+			l++;
+		for (; l < linecount && lines[order[l]].offset < func->end; l++) {
+			hash = fnv1a_buf(hash, &lines[order[l]].offset, sizeof(int));
+			hash = fnv1a_buf(hash, lines[order[l]].symbol, strlen(lines[order[l]].symbol) + 1);
+		}
+
+		hashes[f] = hash;
+	}
+
+	free(order);
+	return 1;
+}
+
+
+// record the content hash of an output file, returns 1 if it is new or changed and needs to be written
+int watch_changed(const char* file, uint32_t hash) {
+	uint32_t slot;
+
+	if (!outputs) {
+		outputs = (outputhash_t*)calloc(OUTPUT_HASH_SIZE, sizeof(outputhash_t));
+		if (!outputs)
+			return 1;
+	}
+
+	slot = fnv1a_buf(FNV1A_INIT, file, strlen(file)) & (OUTPUT_HASH_SIZE - 1);
+	while (outputs[slot].file && strcmp(outputs[slot].file, file))
+		slot = (slot + 1) & (OUTPUT_HASH_SIZE - 1);
+
+	if (!outputs[slot].file) {
+		outputs[slot].file = strdup(file);
+		outputs[slot].hash = hash;
+		outputs[slot].generation = generation;
+		return 1;
+	}
+
+	if (outputs[slot].generation < 0 || outputs[slot].hash != hash) {
+		outputs[slot].hash = hash;
+		outputs[slot].generation = generation;
+		return 1;
+	}
+
+	outputs[slot].generation = generation;
+	return 0;
+}
+
+
+// delete output files that weren't passed to watch_changed since the last sweep
+void watch_sweep(void) {
+	if (outputs) {
+		for (int i = 0; i < OUTPUT_HASH_SIZE; i++) {
+			if (!outputs[i].file || outputs[i].generation < 0 || outputs[i].generation == generation)
+				continue;
+			printf("Removing %s\n", outputs[i].file);
+			remove(outputs[i].file);
+			outputs[i].generation = -1;
+		}
+	}
+	generation++;
+}
@@ -0,0 +1,45 @@
+/*
+QVMOPS - Quake3 Virtual Machine Opcodes disassembler
+Copyright 2004-2026
+https://github.com/thecybermind/qvmops/
+3-clause BSD license: https://opensource.org/license/bsd-3-clause
+
+Created By:
+	Kevin Masterson < k.m.masterson@gmail.com >
+
+*/
+
+#pragma once
+#ifndef QVMOPS_WATCH_H
+#define QVMOPS_WATCH_H
+
+#include <stdint.h>
+
+// how long files must stay unchanged before a change is reported (a compile usually writes .qvm and .map in a row)
+#define WATCH_SETTLE_MS	300
+// how often files are checked where change notifications aren't available
+#define WATCH_POLL_MS	500
+
+// start watching files for changes
+int watch_begin(const char** files, int count);
+
+// block until a watched file has changed and settled, returns 0 on error
+int watch_wait(void);
+
+// stop watching files and forget output hashes
+void watch_end(void);
+
+// hash of the names and offsets of all symbols
+uint32_t watch_hash_symbols(void);
+
+// hash of everything that affects the disassembly of each function into hashes (functioncount entries)
+// returns 0 if out of memory
+int watch_hash_functions(uint32_t symhash, uint32_t* hashes);
+
+// record the content hash of an output file, returns 1 if it is new or changed and needs to be written
+int watch_changed(const char* file, uint32_t hash);
+
+// delete output files that weren't passed to watch_changed since the last sweep
+void watch_sweep(void);
+
+#endif // QVMOPS_WATCH_H